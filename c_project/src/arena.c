@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include "arena.h"
+
+#define MIN_BLOCK_SIZE (64 << 10)
+#define MAX_BLOCK_SIZE (16 << 20)
+#define HUGE_PAGE_SIZE (2 << 20)
+#define DEFAULT_ALIGN 8
+
+struct ArenaBlock {
+  ArenaBlock* prev;
+  char* data;
+  size_t size; //usable bytes from data
+  size_t used;
+  size_t map_len; //> 0 if obtained from mmap()
+};
+
+static atomic_bool default_huge_pages = false;
+
+void arena_use_huge_pages(bool on)
+{
+  default_huge_pages = on;
+}
+
+Arena* new_arena(void)
+{
+  Arena* a = malloc(sizeof(Arena));
+  a->head = NULL;
+  a->next_block_size = MIN_BLOCK_SIZE;
+  a->huge_pages = default_huge_pages;
+  a->last = NULL;
+  a->map = NULL;
+  a->map_len = 0;
+  return a;
+}
+
+static ArenaBlock* new_block(size_t size, bool huge_pages)
+{
+  ArenaBlock* b = NULL;
+  size_t header = (sizeof(ArenaBlock) + 63) & ~(size_t)63;
+  size_t map_len = 0;
+  if (huge_pages) {
+    map_len = (header + size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+    void* mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    mem = mmap(NULL, map_len, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (mem == MAP_FAILED) {
+      // No reserved huge pages: ask for transparent ones
+      mem = mmap(NULL, map_len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+      if (mem != MAP_FAILED)
+        madvise(mem, map_len, MADV_HUGEPAGE);
+#endif
+    }
+    if (mem != MAP_FAILED) {
+      b = mem;
+      size = map_len - header;
+    }
+    else
+      map_len = 0;
+  }
+  if (b == NULL)
+    b = aligned_alloc(64, header + ((size + 63) & ~(size_t)63));
+  b->data = (char*)b + header;
+  b->size = size;
+  b->used = 0;
+  b->map_len = map_len;
+  b->prev = NULL;
+  return b;
+}
+
+void* arena_alloc_aligned(Arena* a, size_t bytes, size_t align)
+{
+  ArenaBlock* b = a->head;
+  if (b != NULL) {
+    uintptr_t start = (uintptr_t)(b->data + b->used);
+    start = (start + align - 1) & ~(uintptr_t)(align - 1);
+    if (start + bytes <= (uintptr_t)(b->data + b->size)) {
+      b->used = start + bytes - (uintptr_t)b->data;
+      a->last = (void*)start;
+      return a->last;
+    }
+  }
+  // Current block is full: chain a new one (at least as large as request)
+  size_t size = a->next_block_size;
+  if (size < bytes + align)
+    size = bytes + align;
+  if (a->next_block_size < MAX_BLOCK_SIZE)
+    a->next_block_size *= 2;
+  ArenaBlock* nb = new_block(size, a->huge_pages);
+  nb->prev = b;
+  a->head = nb;
+  uintptr_t start = (uintptr_t)nb->data;
+  start = (start + align - 1) & ~(uintptr_t)(align - 1);
+  nb->used = start + bytes - (uintptr_t)nb->data;
+  a->last = (void*)start;
+  return a->last;
+}
+
+void* arena_alloc(Arena* a, size_t bytes)
+{
+  return arena_alloc_aligned(a, bytes, DEFAULT_ALIGN);
+}
+
+void* arena_grow(Arena* a, void* p, size_t old_bytes, size_t new_bytes)
+{
+  if (p == NULL)
+    return arena_alloc(a, new_bytes);
+  ArenaBlock* b = a->head;
+  if (p == a->last && (char*)p + new_bytes <= b->data + b->size) {
+    b->used = (char*)p + new_bytes - b->data;
+    return p;
+  }
+  void* q = arena_alloc(a, new_bytes);
+  memcpy(q, p, old_bytes);
+  return q;
+}
+
+void arena_attach_mapping(Arena* a, void* addr, size_t len)
+{
+  if (a->map != NULL)
+    munmap(a->map, a->map_len);
+  a->map = addr;
+  a->map_len = len;
+}
+
+static void free_blocks(ArenaBlock* b)
+{
+  while (b != NULL) {
+    ArenaBlock* prev = b->prev;
+    if (b->map_len > 0)
+      munmap(b, b->map_len);
+    else
+      free(b);
+    b = prev;
+  }
+}
+
+void arena_reset(Arena* a)
+{
+  ArenaBlock* b = a->head;
+  if (b != NULL && b->prev != NULL) {
+    // Several blocks: one of their total size serves the next round
+    size_t total = 0;
+    for (ArenaBlock* c = b; c != NULL; c = c->prev)
+      total += c->size;
+    free_blocks(b);
+    b = a->head = new_block(total, a->huge_pages);
+  }
+  if (b != NULL)
+    b->used = 0;
+  a->last = NULL;
+}
+
+void arena_free(Arena* a)
+{
+  if (a == NULL)
+    return;
+  if (a->map != NULL)
+    munmap(a->map, a->map_len);
+  free_blocks(a->head);
+  free(a);
+}
@@ -0,0 +1,40 @@
+#ifndef GREM_ARENA_H
+#define GREM_ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+// Region allocator: bump allocation inside large blocks,
+// everything is released at once by arena_free().
+typedef struct Arena {
+  ArenaBlock* head; //current block (linked to the previous ones)
+  size_t next_block_size;
+  bool huge_pages; //back blocks with (transparent) huge pages
+  void* last; //last allocation, which can grow in place
+  void* map; //optional file mapping, unmapped by arena_free()
+  size_t map_len;
+} Arena;
+
+// Default backing for new arenas (false unless changed)
+void arena_use_huge_pages(bool on);
+
+Arena* new_arena(void);
+
+// Memory is 8-bytes aligned by default, returned uninitialized
+void* arena_alloc(Arena* a, size_t bytes);
+void* arena_alloc_aligned(Arena* a, size_t bytes, size_t align);
+
+// Enlarge an allocation: in place if it is the last one, copy otherwise
+void* arena_grow(Arena* a, void* p, size_t old_bytes, size_t new_bytes);
+
+// Hand over a mmap()ed region: it lives as long as the arena
+void arena_attach_mapping(Arena* a, void* addr, size_t len);
+
+// Forget all allocations but keep the memory (in one block) for reuse
+void arena_reset(Arena* a);
+
+void arena_free(Arena* a);
+
+#endif
@@ -1,19 +1,17 @@
 #include "graph.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
 #include <math.h>
-#include <time.h>
+#include "rng.h"
+#include "parallel.h"
 
-void init_rand_gen(int seed)
-{
-  if (seed >= 0)
-    srand(seed);
-  else
-    srand(time(NULL));
-}
+#define ALIGNMENT 64
+#define MIN_CAPACITY 8 //8 doubles = 64 bytes, keeps y and dy aligned
 
-// Reallocate space for an overflowed vector
-void tryRealloc(void** v, int cell_size, int size, int nb)
+// Reallocate space for an overflowed vector (inside the graph arena)
+void tryRealloc(Arena* a, void** v, int cell_size, int size, int nb)
 {
   // Capacity = closest power of 2 above current size
   int capacity = 0;
@@ -21,188 +19,505 @@ void tryRealloc(void** v, int cell_size, int size, int nb)
     capacity = 1 << (int)ceil(log2(size));
   if (size + nb > capacity) {
     int new_capacity = 1 << (int)ceil(log2(size + nb));
-    *v = realloc(*v, new_capacity * cell_size);
+    *v = arena_grow(a, *v, (size_t)capacity * cell_size,
+                    (size_t)new_capacity * cell_size);
   }
 }
 
+// Move a pair of double arrays (a, b = a + old_cap) into an aligned buffer
+static double* realloc_pair(Arena* arena, double* a, int n, int old_cap, int new_cap)
+{
+  double* buf = arena_alloc_aligned(arena, 2 * new_cap * sizeof(double), ALIGNMENT);
+  if (a != NULL) {
+    memcpy(buf, a, n * sizeof(double));
+    memcpy(buf + new_cap, a + old_cap, n * sizeof(double));
+  }
+  return buf;
+}
+
+// Move an array of n cells into a larger one
+static void* realloc_cells(Arena* arena, void* v, int cell_size, int n, int new_cap)
+{
+  void* buf = arena_alloc(arena, (size_t)new_cap * cell_size);
+  if (v != NULL)
+    memcpy(buf, v, (size_t)n * cell_size);
+  return buf;
+}
+
+// Grow all per-node arrays to hold at least n_total nodes
+// (previous buffers stay in the arena until the graph is freed)
+void reserve_nodes(Graph* g, int n_total)
+{
+  if (n_total <= g->capacity)
+    return;
+  int capacity = MIN_CAPACITY;
+  while (capacity < n_total)
+    capacity *= 2;
+  Arena* a = g->arena;
+  g->x = realloc_pair(a, g->x, g->n, g->capacity, capacity);
+  g->y = g->x + capacity;
+  g->dx = realloc_pair(a, g->dx, g->n, g->capacity, capacity);
+  g->dy = g->dx + capacity;
+  g->degree = realloc_cells(a, g->degree, sizeof(int), g->n, capacity);
+  g->neighbors = realloc_cells(a, g->neighbors, sizeof(int*), g->n, capacity);
+  g->size = realloc_cells(a, g->size, sizeof(int), g->n, capacity);
+  g->color = realloc_cells(a, g->color, sizeof(int), g->n, capacity);
+  g->capacity = capacity;
+}
+
+// Empty graph, with a new arena for its buffers
+void init_graph(Graph* g)
+{
+  g->n = g->capacity = 0;
+  g->x = g->y = g->dx = g->dy = NULL;
+  g->degree = NULL;
+  g->neighbors = NULL;
+  g->size = NULL;
+  g->color = NULL;
+  g->arena = new_arena();
+}
+
 // Initialize a graph with only nodes (no edges)
-void re_init_nodes(Graph* g, int n, double width, bool random)
+// Random positions drawn from rng, or all at 0 if rng is NULL.
+void re_init_nodes(Graph* g, int n, double width, Rng* rng)
 {
-  tryRealloc((void**)&g->nodes, sizeof(Node), g->n, n);
+  reserve_nodes(g, g->n + n);
   // Positions initiales aléatoires, ou tout à 0 (puis choix dans algo)
   for (int i = g->n; i < g->n + n; i++) {
-    g->nodes[i].id = i;
-    g->nodes[i].color = i; //same as ID in general (TODO: could change)
-    if (random) {
-      g->nodes[i].x = ((double) rand() / RAND_MAX) * width;
-      g->nodes[i].y = ((double) rand() / RAND_MAX) * width;
+    g->color[i] = i; //same as ID in general (TODO: could change)
+    if (rng != NULL) {
+      g->x[i] = rng_uniform(rng) * width;
+      g->y[i] = rng_uniform(rng) * width;
     }
     else
-      g->nodes[i].x = g->nodes[i].y = 0;
-    g->nodes[i].dx = g->nodes[i].dy = 0;
-    g->nodes[i].degree = 0;
-    g->nodes[i].neighbors = NULL;
-    g->nodes[i].size = 0;
+      g->x[i] = g->y[i] = 0;
+    g->dx[i] = g->dy[i] = 0;
+    g->degree[i] = 0;
+    g->neighbors[i] = NULL;
+    g->size[i] = 0;
   }
   g->n += n;
 }
 
+// Build adjacency lists from undirected edges {edges[2k], edges[2k+1]}
+// given in nparts buffers, by counting sort: one packed block, neighbors
+// in edges order. Lists built this way are exact-sized (no room to grow
+// with tryRealloc).
+void build_adjacency_parts(Graph* g, int* const* parts, const long* counts,
+                           int nparts)
+{
+  long m = 0;
+  for (int i = 0; i < g->n; i++)
+    g->degree[i] = 0;
+  for (int b = 0; b < nparts; b++) {
+    for (long k = 0; k < 2*counts[b]; k++)
+      g->degree[parts[b][k]]++;
+    m += counts[b];
+  }
+  int* block = arena_alloc(g->arena, 2 * m * sizeof(int));
+  long offset = 0;
+  for (int i = 0; i < g->n; i++) {
+    g->neighbors[i] = (g->degree[i] > 0 ? block + offset : NULL);
+    offset += g->degree[i];
+    g->degree[i] = 0; //used as fill counter below
+  }
+  for (int b = 0; b < nparts; b++) {
+    const int* edges = parts[b];
+    for (long k = 0; k < counts[b]; k++) {
+      int u = edges[2*k], v = edges[2*k+1];
+      g->neighbors[u][g->degree[u]++] = v;
+      g->neighbors[v][g->degree[v]++] = u;
+    }
+  }
+}
+
+void build_adjacency(Graph* g, const int* edges, long m)
+{
+  int* parts[1] = {(int*)edges};
+  build_adjacency_parts(g, parts, &m, 1);
+}
+
+static int cmp_int(const void* a, const void* b)
+{
+  int u = *(const int*)a, v = *(const int*)b;
+  return (u > v) - (u < v);
+}
+
+void sort_ints(int* v, int n)
+{
+  if (n > 32)
+    qsort(v, n, sizeof(int), cmp_int);
+  else {
+    // Insertion sort is faster on short lists
+    for (int j = 1; j < n; j++) {
+      int x = v[j], k = j;
+      for (; k > 0 && v[k-1] > x; k--)
+        v[k] = v[k-1];
+      v[k] = x;
+    }
+  }
+}
+
+// Remove self-loops and multiple edges; neighbors lists end up sorted
+void simplify_graph(Graph* g)
+{
+  for (int i = 0; i < g->n; i++) {
+    int* nb = g->neighbors[i];
+    sort_ints(nb, g->degree[i]);
+    int d = 0;
+    for (int j = 0; j < g->degree[i]; j++) {
+      if (nb[j] != i && (d == 0 || nb[j] != nb[d-1]))
+        nb[d++] = nb[j];
+    }
+    g->degree[i] = d;
+  }
+}
+
+int* list_edges(const Graph* g, long* m)
+{
+  long count = 0;
+  for (int i = 0; i < g->n; i++) {
+    for (int j = 0; j < g->degree[i]; j++)
+      count += (g->neighbors[i][j] > i);
+  }
+  int* edges = malloc((count > 0 ? 2 * count : 1) * sizeof(int));
+  long k = 0;
+  for (int i = 0; i < g->n; i++) {
+    for (int j = 0; j < g->degree[i]; j++) {
+      int v = g->neighbors[i][j];
+      if (v > i) {
+        edges[k++] = i;
+        edges[k++] = v;
+      }
+    }
+  }
+  *m = count;
+  return edges;
+}
+
+// Pairs (v, w < v) are cut into ER_BLOCKS ranges of rows with about the
+// same number of pairs. Block b draws from the b-th stream split from the
+// seed, so the output does not depend on the number of threads.
+#define ER_BLOCKS 256
+
+typedef struct ErBlock {
+  int v0, v1; //rows range
+  Rng rng;
+  int* edges;
+  long m;
+} ErBlock;
+
+typedef struct ErJob {
+  ErBlock* blocks;
+  double p;
+} ErJob;
+
+// Batagelj-Brandes: jump directly from one edge to the next among pairs
+// (v, w < v), skip lengths being geometric -> O(pairs * p) time.
+static void er_block(void* ctx, int b)
+{
+  ErJob* job = ctx;
+  ErBlock* blk = &job->blocks[b];
+  double pairs = 0.5 * ((double)blk->v1 * (blk->v1 - 1) -
+                        (double)blk->v0 * (blk->v0 - 1));
+  long capacity = (long)(job->p * pairs) + 16;
+  blk->edges = malloc(2 * capacity * sizeof(int));
+  blk->m = 0;
+  double lq = log(1.0 - job->p); //-inf if p == 1: no skips
+  long v = blk->v0, w = -1;
+  while (v < blk->v1) {
+    double r = rng_uniform(&blk->rng); //in [0,1)
+    double skip = floor(log(1.0 - r) / lq);
+    if (skip >= pairs)
+      break; //beyond last pair
+    w += 1 + (long)skip;
+    while (w >= v && v < blk->v1) {
+      w -= v;
+      v++;
+    }
+    if (v < blk->v1) {
+      if (blk->m == capacity) {
+        capacity *= 2;
+        blk->edges = realloc(blk->edges, 2 * capacity * sizeof(int));
+      }
+      blk->edges[2*blk->m] = (int)w;
+      blk->edges[2*blk->m+1] = (int)v;
+      blk->m++;
+    }
+  }
+}
+
 // Crée un graphe aléatoire G(n,p) avec positions initiales aléatoires
+// Rows blocks are sampled in parallel, in O(n + m) total.
 Graph make_random_graph(int n, double p, double width, int seed)
 {
-  init_rand_gen(seed);
+  Rng rng;
+  rng_init(&rng, seed);
   Graph g;
-  g.nodes = NULL;
-  g.n = 0;
-  re_init_nodes(&g, n, width, true);
-  for (int i = 0; i < n; i++) {
-    for (int j = i+1; j < n; j++) {
-      if (((double) rand() / RAND_MAX) < p) {
-        tryRealloc((void**)&g.nodes[i].neighbors, sizeof(int),
-                   g.nodes[i].degree, 1);
-        tryRealloc((void**)&g.nodes[j].neighbors, sizeof(int),
-                   g.nodes[j].degree, 1);
-        g.nodes[i].neighbors[g.nodes[i].degree] = j;
-        g.nodes[j].neighbors[g.nodes[j].degree] = i;
-        g.nodes[i].degree++;
-        g.nodes[j].degree++;
-      }
-    }
+  init_graph(&g);
+  re_init_nodes(&g, n, width, &rng);
+  if (p <= 0.0 || n <= 1)
+    return g;
+  ErBlock* blocks = malloc(ER_BLOCKS * sizeof(ErBlock));
+  double total = 0.5 * n * (n - 1.0);
+  int v = 1;
+  for (int b = 0; b < ER_BLOCKS; b++) {
+    blocks[b].v0 = v;
+    double target = total * (b + 1) / ER_BLOCKS;
+    while (v < n && 0.5 * v * (v - 1.0) < target)
+      v++;
+    blocks[b].v1 = (b == ER_BLOCKS - 1 ? n : v);
+    blocks[b].rng = rng_split(&rng);
   }
+  ErJob job = {.blocks = blocks, .p = fmin(p, 1.0)}; //p > 1: complete graph
+  parallel_for(ER_BLOCKS, er_block, &job);
+  int* parts[ER_BLOCKS];
+  long counts[ER_BLOCKS];
+  for (int b = 0; b < ER_BLOCKS; b++) {
+    parts[b] = blocks[b].edges;
+    counts[b] = blocks[b].m;
+  }
+  build_adjacency_parts(&g, parts, counts, ER_BLOCKS);
+  for (int b = 0; b < ER_BLOCKS; b++)
+    free(blocks[b].edges);
+  free(blocks);
   return g;
 }
 
 // Crée un arbre aléatoire T(n) au hasard, ou preferential attachment
+// PA: picking a uniform endpoint among existing edges selects a node
+// with probability degree / sum(degrees), in O(1).
 Graph make_random_tree(int n, int mode, double width, int seed)
 {
-  init_rand_gen(seed);
+  Rng rng;
+  rng_init(&rng, seed);
   Graph g;
-  g.nodes = NULL;
-  g.n = 0;
-  re_init_nodes(&g, n, width, true);
+  init_graph(&g);
+  re_init_nodes(&g, n, width, &rng);
+  if (n <= 1)
+    return g;
+  int* edges = malloc(2 * (n - 1) * sizeof(int)); //also the endpoints
   for (int i = 1; i < n; i++) {
     int M = 0;
     // tirer au hasard M dans [0, i-1] : rattacher i à M, continuer
     if (mode == RND)
-      M = rand() % i;
-    else {
-      // mode == PA
-      M = i - 1; //default to last
-      int sumDegs = 0;
-      for (int j = 0; j < i; j++)
-        sumDegs += g.nodes[j].degree;
-      if (sumDegs > 0) {
-        double rn = (double) rand() / RAND_MAX;
-        double cumSum = 0.0;
-        for (int j=0; j<i; j++) {
-          cumSum += (double) g.nodes[j].degree / sumDegs;
-          if (rn < cumSum) {
-            M = j;
-            break;
-          }
-        }
+      M = rng_below(&rng, i);
+    else if (i >= 2) {
+      // mode == PA (node 1 can only attach to 0)
+      M = edges[rng_below(&rng, 2 * (i - 1))];
+    }
+    edges[2*(i-1)] = i;
+    edges[2*(i-1)+1] = M;
+  }
+  // Parent comes first in neighbors lists, then children by arrival
+  build_adjacency(&g, edges, n - 1);
+  free(edges);
+  return g;
+}
+
+// Barabasi-Albert: each new node attaches to m distinct existing nodes
+// chosen with probability proportional to their degree. The m first
+// nodes have no edges; node m links to all of them.
+Graph make_random_pa_graph(int n, int m, double width, int seed)
+{
+  Rng rng;
+  rng_init(&rng, seed);
+  Graph g;
+  init_graph(&g);
+  re_init_nodes(&g, n, width, &rng);
+  if (m < 1 || n <= m)
+    return g;
+  long nb_edges = (long)(n - m) * m;
+  int* edges = malloc(2 * nb_edges * sizeof(int)); //also the endpoints
+  int* mark = malloc(n * sizeof(int)); //mark[M] == i: M already chosen by i
+  memset(mark, -1, n * sizeof(int));
+  long k = 0;
+  for (int i = m; i < n; i++) {
+    long first = k;
+    for (int j = 0; j < m; j++) {
+      int M = j; //first new node: all initial ones
+      if (i > m) {
+        do
+          M = edges[rng_below(&rng, 2 * first)];
+        while (mark[M] == i);
       }
+      mark[M] = i;
+      edges[2*k] = i;
+      edges[2*k+1] = M;
+      k++;
     }
-    tryRealloc((void**)&g.nodes[i].neighbors, sizeof(int),
-               g.nodes[i].degree, 1);
-    tryRealloc((void**)&g.nodes[M].neighbors, sizeof(int),
-               g.nodes[M].degree, 1);
-    g.nodes[i].neighbors[g.nodes[i].degree] = M;
-    g.nodes[M].neighbors[g.nodes[M].degree] = i;
-    g.nodes[i].degree++;
-    g.nodes[M].degree++;
   }
+  free(mark);
+  build_adjacency(&g, edges, nb_edges);
+  free(edges);
   return g;
 }
 
-void growOneTwo(Graph* g, int from, int count, int pos, int isz, double width)
+void growOneTwo(Graph* g, Rng* rng, int from, int count, int pos, int isz,
+                double width)
 {
   int old_n = g->n;
-  re_init_nodes(g, count, width, false);
-  tryRealloc((void**)&g->nodes[from].neighbors, sizeof(int),
-             g->nodes[from].degree, count);
+  re_init_nodes(g, count, width, NULL);
+  tryRealloc(g->arena, (void**)&g->neighbors[from], sizeof(int),
+             g->degree[from], count);
   for (int i = 0; i < count; i++) {
     // Random direction from root:
-    double dir_x = (double)rand() / RAND_MAX,
-           dir_y = (double)rand() / RAND_MAX;
+    double dir_x = rng_uniform(rng),
+           dir_y = rng_uniform(rng);
     if (from > 0) {
       // keep direction from parent otherwise
-      dir_x = g->nodes[from].x - g->nodes[ g->nodes[from].neighbors[0] ].x;
-      dir_y = g->nodes[from].y - g->nodes[ g->nodes[from].neighbors[0] ].y;
+      dir_x = g->x[from] - g->x[g->neighbors[from][0]];
+      dir_y = g->y[from] - g->y[g->neighbors[from][0]];
     }
     // Normalize directions:
     double norm = sqrt(dir_x*dir_x + dir_y*dir_y);
     dir_x /= norm;
     dir_y /= norm;
     // Add small random perturbation
-    dir_x += 0.1 * (rand() % 2 == 0 ? 1 : -1) * (double)rand() / RAND_MAX;
-    dir_y += 0.1 * (rand() % 2 == 0 ? 1 : -1) * (double)rand() / RAND_MAX;
-    g->nodes[old_n + i].x = g->nodes[old_n].x + dir_x;
-    g->nodes[old_n + i].y = g->nodes[old_n].y + dir_y;
+    dir_x += 0.1 * (rng_below(rng, 2) == 0 ? 1 : -1) * rng_uniform(rng);
+    dir_y += 0.1 * (rng_below(rng, 2) == 0 ? 1 : -1) * rng_uniform(rng);
+    g->x[old_n + i] = g->x[old_n] + dir_x;
+    g->y[old_n + i] = g->y[old_n] + dir_y;
     if (pos >= 0 && count == 1) {
-      for (int j = g->nodes[from].degree; j > pos; j--)
-        g->nodes[from].neighbors[j] = g->nodes[from].neighbors[j-1];
-      g->nodes[from].neighbors[pos] = old_n;
+      for (int j = g->degree[from]; j > pos; j--)
+        g->neighbors[from][j] = g->neighbors[from][j-1];
+      g->neighbors[from][pos] = old_n;
     }
     else
-      g->nodes[from].neighbors[g->nodes[from].degree + i] = old_n + i;
-    g->nodes[old_n + i].degree = 1;
-    g->nodes[old_n + i].neighbors = malloc(sizeof(int));
-    g->nodes[old_n + i].neighbors[0] = from;
-    g->nodes[old_n + i].size = isz;
+      g->neighbors[from][g->degree[from] + i] = old_n + i;
+    g->degree[old_n + i] = 1;
+    g->neighbors[old_n + i] = arena_alloc(g->arena, sizeof(int));
+    g->neighbors[old_n + i][0] = from;
+    g->size[old_n + i] = isz;
   }
-  g->nodes[from].degree += count;
+  g->degree[from] += count;
 }
 
 // Assume that g is an output of make_random_binary_tree() below
-void grow_binary_tree(Graph* g, double width)
+void grow_binary_tree(Graph* g, Rng* rng, double width)
 {
   int i = 0;
-  while (g->nodes[i].degree >= 2) {
-    g->nodes[i].size += 2; //augment sizes on the path
-    int a_idx = g->nodes[i].neighbors[1 - (i == 0 ? 1 : 0)],
-        b_idx = g->nodes[i].neighbors[2 - (i == 0 ? 1 : 0)];
-    int a = g->nodes[a_idx].size,
-        b = g->nodes[b_idx].size;
+  while (g->degree[i] >= 2) {
+    g->size[i] += 2; //augment sizes on the path
+    int a_idx = g->neighbors[i][1 - (i == 0 ? 1 : 0)],
+        b_idx = g->neighbors[i][2 - (i == 0 ? 1 : 0)];
+    int a = g->size[a_idx],
+        b = g->size[b_idx];
     double Cab = ( (a + 1) * (2*a + 1) * (a + 3*b + 3) ) /
       ( (a + b + 1) * (a + b + 2) * (2 * (a + b) + 3) );
-    double lr = (double)rand() / RAND_MAX;
+    double lr = rng_uniform(rng);
     i = (lr < Cab ? a_idx : b_idx);
   }
   // Grow one cherry from current leaf.
-  growOneTwo(g, i, 2, -1, 0, width);
+  growOneTwo(g, rng, i, 2, -1, 0, width);
 }
 
 Graph make_random_binary_tree(int n, double width, int seed)
 {
-  init_rand_gen(seed);
+  Rng rng;
+  rng_init(&rng, seed);
   Graph g;
-  g.nodes = NULL;
-  g.n = 0;
-  re_init_nodes(&g, 1, width, true);
+  init_graph(&g);
+  reserve_nodes(&g, n + 1); //last cherry may overshoot by one
+  re_init_nodes(&g, 1, width, &rng);
   while (g.n < n)
-    grow_binary_tree(&g, width);
+    grow_binary_tree(&g, &rng, width);
+  return g;
+}
+
+static int remy_tree(Rng* rng, int k, int* parent, int* child)
+{
+  int root = 0;
+  parent[0] = -1;
+  child[0] = child[1] = -1;
+  for (int t = 1; t <= k; t++) {
+    int a = 2*t - 1, //new internal node, takes the place of x
+        b = 2*t; //new leaf, sibling of x
+    int x = rng_below(rng, a);
+    parent[a] = parent[x];
+    if (parent[x] < 0)
+      root = a;
+    else {
+      int* slot = &child[2 * parent[x]];
+      slot[slot[0] == x ? 0 : 1] = a;
+    }
+    int side = rng_below(rng, 2);
+    child[2*a + side] = x;
+    child[2*a + 1 - side] = b;
+    child[2*b] = child[2*b + 1] = -1;
+    parent[x] = parent[b] = a;
+  }
+  return root;
+}
+
+int remy_binary_tree(int k, int* parent, int* child, int seed)
+{
+  Rng rng;
+  rng_init(&rng, seed);
+  return remy_tree(&rng, k, parent, child);
+}
+
+Graph make_remy_binary_tree(int n, double width, int seed)
+{
+  Rng rng;
+  rng_init(&rng, seed);
+  int k = (n > 1 ? n / 2 : 0); //same final size as make_random_binary_tree
+  int N = 2*k + 1;
+  int* parent = malloc(N * sizeof(int));
+  int* child = malloc(2 * N * sizeof(int));
+  int root = remy_tree(&rng, k, parent, child);
+  Graph g;
+  init_graph(&g);
+  re_init_nodes(&g, N, width, &rng);
+  // Breadth-first renumbering: root is 0, parents come before children.
+  int* bfs_nodes = malloc(N * sizeof(int));
+  int* edges = malloc(2 * (N - 1) * sizeof(int));
+  int front = 0, back = 0;
+  bfs_nodes[back++] = root;
+  while (front < back) {
+    int u = bfs_nodes[front];
+    for (int side = 0; side < 2; side++) {
+      int c = child[2*u + side];
+      if (c >= 0) {
+        edges[2*(back-1)] = front;
+        edges[2*(back-1)+1] = back;
+        bfs_nodes[back++] = c;
+      }
+    }
+    front++;
+  }
+  // Nodes keep their arrival step as color; size = descendants count
+  for (int i = N - 1; i >= 0; i--) {
+    g.color[i] = bfs_nodes[i];
+    if (i > 0)
+      g.size[edges[2*(i-1)]] += g.size[i] + 1;
+  }
+  // Parent first in neighbors lists, then children
+  build_adjacency(&g, edges, N - 1);
+  free(edges);
+  free(bfs_nodes);
+  free(child);
+  free(parent);
   return g;
 }
 
-// Assume that g is an output of make_random_nary_tree() below
-void grow_nary_tree(Graph* g, double alpha, double width)
+// Assume that g is an output of make_random_nary_tree() below.
+// sumSq[i] = sum of squared sizes of the children of i, kept up to date
+// on the path to the root: with sum(Fi) = f, each descent step is O(k).
+void grow_nary_tree(Graph* g, Rng* rng, long long* sumSq, double alpha,
+                    double width)
 {
   int i = 0,
       pos = 0;
 loopBegin:
-  int f = g->nodes[i].size; //leaves count from local root
+  long long f = g->size[i]; //leaves count from local root
   int start_idx = (i == 0 ? 0 : 1);
-  double loc = (double)rand() / RAND_MAX;
-  int k = g->nodes[i].degree - start_idx; //"up" neighbors count
+  double loc = rng_uniform(rng);
+  int k = g->degree[i] - start_idx; //"up" neighbors count
   if (k == 0)
     goto afterLoop;
   // From here k >= 2
-  int sumFi2 = 0;
-  for (int jj = start_idx; jj < g->nodes[i].degree; jj++) {
-    int fs = g->nodes[ g->nodes[i].neighbors[jj] ].size;
-    sumFi2 += fs * fs;
-  }
+  long long sumFi2 = sumSq[i];
   double p = (k-alpha)*(f*f-sumFi2) / ((alpha*f-1)*(k+1)*((f-1)*f));
   double where = 0.0;
   for (int j = 0; j <= k; j++) {
@@ -212,108 +527,54 @@ loopBegin:
       goto afterLoop;
     }
   }
-  // From here we know will recurse in some sub-tree (k >= 2):
+  // From here we know will recurse in some sub-tree (k >= 2).
+  // With sumFij = (f-fj)^2 - (sumFi2-fj^2), the probability
+  // (alpha*fj-1) * ((fj-1)*fj*(fj+1)+3*fj*(fj+1)*(f-fj)+sumFij*(1+fj))
+  //   / ((alpha*f-1)*(1+fj)*(f-1)*f)
+  // simplifies to C * (alpha*fj-1) * (f^2-sumFi2 + (f-1)*fj):
+  double D = (double)(f*f - sumFi2), C = 1.0 / ((alpha*f-1)*(f-1)*f);
   for (int j = 0; j < k; j++) {
-    int fj = g->nodes[ g->nodes[i].neighbors[j+start_idx] ].size;
-    int sumFij = 0;
-    for (int ii=0; ii<k; ii++) {
-      if (ii == j)
-        continue;
-      for (int jj=0; jj<k; jj++) {
-        if (jj == j || jj == ii)
-          continue;
-        sumFij += g->nodes[ g->nodes[i].neighbors[ii+start_idx] ].size *
-          g->nodes[ g->nodes[i].neighbors[jj+start_idx] ].size;
-      }
-    }
-    p = (alpha*fj-1) * ((fj-1)*fj*(fj+1)+3*fj*(fj+1)*(f-fj)+sumFij*(1+fj))
-      / ((alpha*f-1)*(1+fj)*(f-1)*f);
-    where += p;
+    double fj = g->size[g->neighbors[i][j+start_idx]];
+    where += C * (alpha*fj-1) * (D + (f-1)*fj);
     if (where >= loc) {
-      i = g->nodes[i].neighbors[j+start_idx];
+      i = g->neighbors[i][j+start_idx];
       goto loopBegin;
     }
   }
 afterLoop:
   // Add one or two leaf from current node (at position pos).
-  growOneTwo(g, i, (k == 0 ? 2 : 1), pos, 1, width);
+  growOneTwo(g, rng, i, (k == 0 ? 2 : 1), pos, 1, width);
+  sumSq[i] += (k == 0 ? 2 : 1);
+  sumSq[g->n - 1] = 0;
+  sumSq[g->n - (k == 0 ? 2 : 1)] = 0;
   // Update size from here to root
   while (true) {
-    g->nodes[i].size++;
+    g->size[i]++;
     if (i == 0)
       break;
-    i = g->nodes[i].neighbors[0];
+    int parent = g->neighbors[i][0];
+    sumSq[parent] += 2 * g->size[i] - 1; //(s+1)^2 - s^2
+    i = parent;
   }
 }
 
 Graph make_random_nary_tree(int n, double alpha, double width, int seed)
 {
-  init_rand_gen(seed);
+  Rng rng;
+  rng_init(&rng, seed);
   Graph g;
-  g.nodes = NULL;
-  g.n = 0;
-  re_init_nodes(&g, 1, width, false);
-  g.nodes[0].size = 1; //root = leaf for now
+  init_graph(&g);
+  reserve_nodes(&g, n + 1); //first growth adds two leaves
+  long long* sumSq = arena_alloc(g.arena, (n + 1) * sizeof(long long));
+  re_init_nodes(&g, 1, width, NULL);
+  g.size[0] = 1; //root = leaf for now
+  sumSq[0] = 0;
   while (g.n < n)
-    grow_nary_tree(&g, alpha, width);
-  return g;
-}
-
-void write_graph(Graph g, char* path)
-{
-  FILE* fptr = fopen(path, "w");
-  int m = 0;
-  for (int i = 0; i < g.n; i++)
-    m += g.nodes[i].degree;
-  m /= 2;
-  fprintf(fptr, "%i %i\n", g.n, m);
-  for (int i=0; i < g.n; i++)
-    fprintf(fptr, "%f %f %i\n", g.nodes[i].x, g.nodes[i].y, g.nodes[i].color);
-  for (int i=0; i < g.n; i++) {
-    for (int j=0; j < g.nodes[i].degree; j++) {
-      if (g.nodes[i].neighbors[j] > i)
-        fprintf(fptr, "%i %i\n", i, g.nodes[i].neighbors[j]);
-    }
-  }
-  fclose(fptr);
-}
-
-Graph read_graph(char* path)
-{
-  FILE* f = fopen(path, "r");
-  int n, m;
-  fscanf(f, "%d %d", &n, &m); //==2
-  Graph g;
-  g.n = n;
-  g.nodes = (Node*)calloc(n, sizeof(Node));
-  // Lecture des coordonnées
-  for (int i = 0; i < n; i++) {
-    Node* nd = &g.nodes[i];
-    nd->id = i;
-    nd->dx = nd->dy = 0.0;
-    nd->degree = 0;
-    nd->neighbors = NULL;
-    fscanf(f, "%lf %lf %d", &nd->x, &nd->y, &nd->color); //==3
-  }
-  // Lecture des arêtes
-  for (int j = 0; j < m; j++) {
-    int u, v;
-    fscanf(f, "%d %d", &u, &v); //==2
-    // Ajoute les voisins symétriquement (graphe non orienté)
-    Node* nu = &g.nodes[u];
-    Node* nv = &g.nodes[v];
-    tryRealloc((void**)&nu->neighbors, sizeof(int), nu->degree, 1);
-    tryRealloc((void**)&nv->neighbors, sizeof(int), nv->degree, 1);
-    nu->neighbors[nu->degree++] = v;
-    nv->neighbors[nv->degree++] = u;
-  }
-  fclose(f);
+    grow_nary_tree(&g, &rng, sumSq, alpha, width);
   return g;
 }
 
 void free_graph(Graph g)
 {
-  for (int i=0; i < g.n; i++)
-    free(g.nodes[i].neighbors);
-  free(g.nodes);
+  arena_free(g.arena);
 }
@@ -1,38 +1,72 @@
 #ifndef GREM_GRAPH_H
 #define GREM_GRAPH_H
 
-typedef struct Node {
-  int id;
-  double x, y;
-  double dx, dy;
-  int degree;
-  int* neighbors;
-  int size; //for (bi)nary trees only
-  int color; //order of appearance (exact or estimated) for tree
-} Node;
+#include "arena.h"
+#include "rng.h"
 
+// Nodes are stored as a structure of arrays: node i is identified by its
+// index, and its attributes are found at index i of each array below.
 typedef struct Graph {
   int n;
-  Node* nodes;
+  int capacity; //allocated slots in each per-node array
+  // Hot data (force loops): 64-bytes aligned, y = x + capacity, dy = dx + capacity
+  double *x, *y;
+  double *dx, *dy;
+  // Adjacency
+  int* degree;
+  int** neighbors;
+  // Cold metadata
+  int* size; //for (bi)nary trees only
+  int* color; //order of appearance (exact or estimated) for tree
+  Arena* arena; //owns all buffers above
 } Graph;
 
-// Build Erdos-Renyi graph
+// Construction helpers (for generators and readers)
+void init_graph(Graph* g); //empty graph with its arena
+void reserve_nodes(Graph* g, int n_total);
+// Append n isolated nodes, at random in [0, width]^2 (or at 0 if !rng)
+void re_init_nodes(Graph* g, int n, double width, Rng* rng);
+
+// Build Erdos-Renyi graph, in O(n + m) (multithreaded, same output for
+// any number of threads)
 Graph make_random_graph(int n, double p, double width, int seed);
 
 enum {RND=0, PA};
 
-// Build random tree, at random or preferential attachment
+// Build random tree, at random or preferential attachment, in O(n)
 Graph make_random_tree(int n, int mode, double width, int seed);
 
+// Barabasi-Albert graph: preferential attachment with m edges per node
+Graph make_random_pa_graph(int n, int m, double width, int seed);
+
 // Random binary tree following https://arxiv.org/pdf/2401.07891
 Graph make_random_binary_tree(int n, double width, int seed);
 
+// Uniform random binary tree with k internal nodes by Remy's algorithm,
+// in O(k): flat arrays of 2k+1 cells, parent (-1 at root) and children
+// child[2i], child[2i+1] (-1 for leaves). Node ids = arrival order.
+// Returns the root.
+int remy_binary_tree(int k, int* parent, int* child, int seed);
+
+// Same as above converted to a graph (root = node 0), in O(n)
+Graph make_remy_binary_tree(int n, double width, int seed);
+
 // Random n-ary tree following [source?]
 Graph make_random_nary_tree(int n, double alpha, double width, int seed);
 
-// Read/write functions (from/to file)
-void write_graph(Graph g, char* path);
-Graph read_graph(char* path);
+// Replace adjacency by m edges {edges[2k], edges[2k+1]} (counting sort)
+void build_adjacency(Graph* g, const int* edges, long m);
+// Same with edges split in nparts buffers, taken in order
+void build_adjacency_parts(Graph* g, int* const* parts, const long* counts,
+                           int nparts);
+
+// Sort a (neighbors) list in increasing order
+void sort_ints(int* v, int n);
+// Remove self-loops and multiple edges (sorts neighbors lists)
+void simplify_graph(Graph* g);
+// Edges {edges[2k], edges[2k+1]} with edges[2k] < edges[2k+1], by node
+// then neighbors order; *m receives their number. Caller frees.
+int* list_edges(const Graph* g, long* m);
 
 void free_graph(Graph g);
 
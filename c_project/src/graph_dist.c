@@ -13,8 +13,8 @@ void bfs(Graph* g, int start, int* dist) {
 
   while (front < back) {
     int u = queue[front++];
-    for (int j = 0; j < g->nodes[u].degree; j++) {
-      int v = g->nodes[u].neighbors[j];
+    for (int j = 0; j < g->degree[u]; j++) {
+      int v = g->neighbors[u][j];
       if (dist[v] == INT_MAX) {
         dist[v] = dist[u] + 1;
         queue[back++] = v;
@@ -0,0 +1,2052 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include "graph_io.h"
+#include "parallel.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "binary graph format is written for little-endian hosts"
+#endif
+
+#define BIN_MAGIC "GREMBIN" //with final '\0': 8 bytes
+#define BIN_VERSION 1
+#define BIN_HEADER_SIZE 128
+#define BIN_ALIGN 64
+
+static _Thread_local char error_msg[256];
+
+const char* graph_error(void)
+{
+  return error_msg;
+}
+
+void set_graph_error(const char* fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(error_msg, sizeof(error_msg), fmt, args);
+  va_end(args);
+}
+
+// Graph returned on failure
+static Graph bad_graph(void)
+{
+  Graph g;
+  init_graph(&g);
+  g.n = -1;
+  return g;
+}
+
+/////////////////////////////
+// Text format
+/////////////////////////////
+
+// Writer: nodes are split in ranges formatted in parallel, each range
+// into two buffers (its node lines, its edge lines), then all buffers go
+// to the file in order through writev().
+#define WRITE_RANGE (1 << 16) //nodes per task, at least
+#ifndef IOV_MAX
+#define IOV_MAX 1024 //Linux value
+#endif
+
+static const char digit_pairs[201] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+// Decimal digits of v at p, returns the end
+static char* put_uint(char* p, uint64_t v)
+{
+  char tmp[20];
+  char* q = tmp + sizeof(tmp);
+  while (v >= 100) {
+    unsigned r = (unsigned)(v % 100);
+    v /= 100;
+    q -= 2;
+    memcpy(q, &digit_pairs[2 * r], 2);
+  }
+  if (v >= 10) {
+    q -= 2;
+    memcpy(q, &digit_pairs[2 * v], 2);
+  }
+  else
+    *--q = '0' + (char)v;
+  size_t len = tmp + sizeof(tmp) - q;
+  memcpy(p, q, len);
+  return p + len;
+}
+
+static char* put_int(char* p, long v)
+{
+  if (v < 0) {
+    *p++ = '-';
+    return put_uint(p, -(uint64_t)v);
+  }
+  return put_uint(p, v);
+}
+
+// "int.frac" for q / 10^decimals (frac on exactly decimals digits)
+static char* put_decimal(char* p, bool neg, uint64_t q, int decimals,
+                         uint64_t pow10)
+{
+  if (neg)
+    *p++ = '-';
+  p = put_uint(p, q / pow10);
+  if (decimals > 0) {
+    uint64_t frac = q % pow10;
+    *p++ = '.';
+    for (int k = decimals - 1; k >= 0; k--, frac /= 10)
+      p[k] = '0' + frac % 10;
+    p += decimals;
+  }
+  return p;
+}
+
+// |v| = m / 2^s exactly, with m < 2^53 (v finite, nonzero, |v| < 2^53)
+static inline uint64_t split_double(double v, int* s)
+{
+  int e;
+  double f = frexp(fabs(v), &e); //|v| = f * 2^e, f in [0.5, 1)
+  *s = 53 - e;
+  return (uint64_t)ldexp(f, 53);
+}
+
+// round(m * 10^P / 2^s), half to even
+static inline unsigned __int128 round_scaled(uint64_t m, unsigned __int128 pow10,
+                                             int s)
+{
+  unsigned __int128 N = (unsigned __int128)m * pow10;
+  if (s <= 0)
+    return N << -s;
+  unsigned __int128 q = N >> s, r = N - (q << s),
+                    half = (unsigned __int128)1 << (s - 1);
+  if (r > half || (r == half && (q & 1)))
+    q++;
+  return q;
+}
+
+// Same output as printf("%f", v): v * 10^6 rounded half-to-even on the
+// exact binary value, in 128-bit integers. Huge values go to libc.
+static char* put_fixed6(char* p, double v)
+{
+  if (v == 0.0)
+    return put_decimal(p, signbit(v), 0, 6, 1000000);
+  int s;
+  uint64_t m = split_double(v, &s);
+  if (!isfinite(v) || s < -54 || s > 120)
+    return p + sprintf(p, "%f", v); //beyond 128 bits, or ~0
+  unsigned __int128 q = round_scaled(m, 1000000, s);
+  if (q >> 64)
+    return p + sprintf(p, "%f", v);
+  return put_decimal(p, signbit(v), (uint64_t)q, 6, 1000000);
+}
+
+// Shortest decimal form reading back as the same double: fewest
+// decimals P such that round(v * 10^P) / 10^P lies within half an ulp of
+// v (strictly: ties are avoided). Exact integer test for 1e-3 <= |v| <
+// 2^53, libc search for other values.
+static char* put_exact(char* p, double v)
+{
+  double a = fabs(v);
+  if (a >= 1e-3 && a < 9007199254740992.0) {
+    int s;
+    uint64_t m = split_double(v, &s);
+    bool pow2 = (m == (uint64_t)1 << 52); //ulp below is half the ulp above
+    uint64_t pow10 = 1;
+    for (int P = 0; P <= 19; P++, pow10 *= 10) {
+      unsigned __int128 q = round_scaled(m, pow10, s);
+      // Error in units of 2^-s / 10^P: q * 2^s - m * 10^P
+      unsigned __int128 qs = q << s, N = (unsigned __int128)m * pow10;
+      bool below = qs < N;
+      unsigned __int128 err = (below ? N - qs : qs - N);
+      if ((below && pow2 ? 4 * err : 2 * err) < pow10)
+        return put_decimal(p, signbit(v), (uint64_t)q, P, pow10);
+    }
+  }
+  for (int digits = 15; digits < 17; digits++) {
+    int len = sprintf(p, "%.*g", digits, v);
+    if (strtod(p, NULL) == v)
+      return p + len;
+  }
+  return p + sprintf(p, "%.17g", v);
+}
+
+typedef struct TextOut {
+  char* data;
+  size_t len, capacity;
+} TextOut;
+
+// Room for at least one more line (formatted doubles can be long)
+static inline void reserve_line(TextOut* out)
+{
+  if (out->capacity - out->len < 1024) {
+    out->capacity = (out->capacity == 0 ? 1 << 16 : 2 * out->capacity);
+    out->data = realloc(out->data, out->capacity);
+  }
+}
+
+typedef struct WriteJob {
+  const Graph* g;
+  bool exact;
+  int nb_ranges;
+  TextOut* nodes; //per range
+  TextOut* edges;
+} WriteJob;
+
+static void format_range(void* ctx, int t)
+{
+  WriteJob* job = ctx;
+  const Graph* g = job->g;
+  int i0 = (int)((long)g->n * t / job->nb_ranges),
+      i1 = (int)((long)g->n * (t + 1) / job->nb_ranges);
+  TextOut* out = &job->nodes[t];
+  for (int i = i0; i < i1; i++) {
+    reserve_line(out);
+    char* p = out->data + out->len;
+    p = (job->exact ? put_exact(p, g->x[i]) : put_fixed6(p, g->x[i]));
+    *p++ = ' ';
+    p = (job->exact ? put_exact(p, g->y[i]) : put_fixed6(p, g->y[i]));
+    *p++ = ' ';
+    p = put_int(p, g->color[i]);
+    *p++ = '\n';
+    out->len = p - out->data;
+  }
+  out = &job->edges[t];
+  for (int i = i0; i < i1; i++) {
+    for (int j = 0; j < g->degree[i]; j++) {
+      if (g->neighbors[i][j] > i) {
+        reserve_line(out);
+        char* p = out->data + out->len;
+        p = put_int(p, i);
+        *p++ = ' ';
+        p = put_int(p, g->neighbors[i][j]);
+        *p++ = '\n';
+        out->len = p - out->data;
+      }
+    }
+  }
+}
+
+// All of iov to fd, in as few system calls as allowed
+static bool write_all(int fd, struct iovec* iov, int cnt)
+{
+  while (cnt > 0) {
+    ssize_t k = writev(fd, iov, (cnt < IOV_MAX ? cnt : IOV_MAX));
+    if (k < 0 && errno == EINTR)
+      continue; //interrupted by a signal before writing anything
+    if (k < 0)
+      return false;
+    // Skip what was written
+    while (cnt > 0 && (size_t)k >= iov->iov_len) {
+      k -= iov->iov_len;
+      iov++;
+      cnt--;
+    }
+    if (cnt > 0) {
+      iov->iov_base = (char*)iov->iov_base + k;
+      iov->iov_len -= k;
+    }
+  }
+  return true;
+}
+
+static int write_text(const Graph* g, const char* path, bool exact)
+{
+  bool is_stdout = (strcmp(path, "-") == 0);
+  int fd = (is_stdout ? STDOUT_FILENO
+                      : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+  if (fd < 0) {
+    set_graph_error("cannot open %s for writing", path);
+    return -1;
+  }
+  long m = 0;
+  for (int i = 0; i < g->n; i++)
+    m += g->degree[i];
+  m /= 2;
+  char header[48];
+  char* p = put_int(header, g->n);
+  *p++ = ' ';
+  p = put_int(p, m);
+  *p++ = '\n';
+  WriteJob job = {.g = g, .exact = exact};
+  job.nb_ranges = 4 * get_num_threads();
+  if (job.nb_ranges > g->n / WRITE_RANGE)
+    job.nb_ranges = g->n / WRITE_RANGE;
+  if (job.nb_ranges < 1)
+    job.nb_ranges = 1;
+  job.nodes = calloc(job.nb_ranges, sizeof(TextOut));
+  job.edges = calloc(job.nb_ranges, sizeof(TextOut));
+  parallel_for(job.nb_ranges, format_range, &job);
+  struct iovec* iov = malloc((2 * job.nb_ranges + 1) * sizeof(struct iovec));
+  iov[0].iov_base = header;
+  iov[0].iov_len = p - header;
+  for (int t = 0; t < job.nb_ranges; t++) {
+    iov[1 + t].iov_base = job.nodes[t].data;
+    iov[1 + t].iov_len = job.nodes[t].len;
+    iov[1 + job.nb_ranges + t].iov_base = job.edges[t].data;
+    iov[1 + job.nb_ranges + t].iov_len = job.edges[t].len;
+  }
+  bool ok = write_all(fd, iov, 2 * job.nb_ranges + 1);
+  if (!is_stdout)
+    ok = (close(fd) == 0) && ok;
+  for (int t = 0; t < job.nb_ranges; t++) {
+    free(job.nodes[t].data);
+    free(job.edges[t].data);
+  }
+  free(iov);
+  free(job.nodes);
+  free(job.edges);
+  if (!ok) {
+    set_graph_error("write error on %s", path);
+    return -1;
+  }
+  return 0;
+}
+
+int write_graph(Graph g, char* path)
+{
+  return write_text(&g, path, false);
+}
+
+int write_graph_exact(Graph g, char* path)
+{
+  return write_text(&g, path, true);
+}
+
+typedef struct Scanner {
+  const char* p;
+  const char* end;
+  long line;
+  const char* path;
+} Scanner;
+
+static inline bool is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Skip whitespace, counting lines. False at end of input.
+static inline bool skip_spaces(Scanner* s)
+{
+  while (s->p < s->end && is_space(*s->p)) {
+    if (*s->p == '\n')
+      s->line++;
+    s->p++;
+  }
+  return s->p < s->end;
+}
+
+// Numbers must be followed by whitespace or the end of input
+static inline bool at_separator(const Scanner* s)
+{
+  return s->p == s->end || is_space(*s->p);
+}
+
+// Length of the token starting at p (for error messages)
+static int token_len(const Scanner* s, const char* p)
+{
+  int len = 0;
+  while (p + len < s->end && !is_space(p[len]) && len < 32)
+    len++;
+  return len;
+}
+
+static bool scan_int(Scanner* s, int* v, const char* what)
+{
+  if (!skip_spaces(s)) {
+    set_graph_error("%s:%ld: missing %s", s->path, s->line, what);
+    return false;
+  }
+  const char* start = s->p;
+  bool neg = (*s->p == '-');
+  if (*s->p == '-' || *s->p == '+')
+    s->p++;
+  long long acc = 0;
+  const char* digits = s->p;
+  while (s->p < s->end && *s->p >= '0' && *s->p <= '9' && acc <= INT32_MAX)
+    acc = 10 * acc + (*s->p++ - '0');
+  if (s->p == digits || !at_separator(s) || acc > (long long)INT32_MAX + neg) {
+    set_graph_error("%s:%ld: invalid %s '%.*s'", s->path, s->line, what,
+              token_len(s, start), start);
+    return false;
+  }
+  *v = (int)(neg ? -acc : acc);
+  return true;
+}
+
+// Any 64-bit integer (node ids of imported files)
+static bool scan_id(Scanner* s, int64_t* v, const char* what)
+{
+  if (!skip_spaces(s)) {
+    set_graph_error("%s:%ld: missing %s", s->path, s->line, what);
+    return false;
+  }
+  const char* start = s->p;
+  bool neg = (*s->p == '-');
+  if (*s->p == '-' || *s->p == '+')
+    s->p++;
+  uint64_t acc = 0;
+  bool overflow = false;
+  const char* digits = s->p;
+  while (s->p < s->end && *s->p >= '0' && *s->p <= '9') {
+    overflow |= (acc > (UINT64_MAX - 9) / 10);
+    acc = 10 * acc + (*s->p++ - '0');
+  }
+  if (s->p == digits || !at_separator(s) || overflow ||
+      acc > (uint64_t)INT64_MAX + neg) {
+    set_graph_error("%s:%ld: invalid %s '%.*s'", s->path, s->line, what,
+              token_len(s, start), start);
+    return false;
+  }
+  *v = (neg ? (int64_t)(0 - acc) : (int64_t)acc);
+  return true;
+}
+
+// Exact powers of ten representable as doubles
+static const double pow10_exact[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Decimal numbers with a mantissa below 2^53 and a power of ten up to 22
+// are converted exactly by one multiplication or division (Clinger's fast
+// path), which covers "%f" output. Anything else goes through strtod().
+static bool scan_double(Scanner* s, double* v, const char* what)
+{
+  if (!skip_spaces(s)) {
+    set_graph_error("%s:%ld: missing %s", s->path, s->line, what);
+    return false;
+  }
+  const char* start = s->p;
+  const char* p = s->p;
+  bool neg = (*p == '-');
+  if (*p == '-' || *p == '+')
+    p++;
+  uint64_t mant = 0;
+  int nb_digits = 0, exp10 = 0;
+  bool any = false;
+  while (p < s->end && *p >= '0' && *p <= '9') {
+    if (nb_digits < 19) {
+      mant = 10 * mant + (*p - '0');
+      if (mant > 0)
+        nb_digits++;
+    }
+    else
+      exp10++;
+    p++;
+    any = true;
+  }
+  if (p < s->end && *p == '.') {
+    p++;
+    while (p < s->end && *p >= '0' && *p <= '9') {
+      if (nb_digits < 19) {
+        mant = 10 * mant + (*p - '0');
+        if (mant > 0)
+          nb_digits++;
+        exp10--;
+      }
+      p++;
+      any = true;
+    }
+  }
+  bool simple = any && (p == s->end || is_space(*p));
+  if (simple && mant < ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22) {
+    double d = (double)mant;
+    d = (exp10 < 0 ? d / pow10_exact[-exp10] : d * pow10_exact[exp10]);
+    *v = (neg ? -d : d);
+    s->p = p;
+    return true;
+  }
+  // Exponents, long mantissas, inf/nan: copy the token for strtod()
+  char token[64];
+  size_t len = 0;
+  while (s->p + len < s->end && !is_space(s->p[len]) && len < sizeof(token) - 1)
+    len++;
+  memcpy(token, start, len);
+  token[len] = '\0';
+  char* stop;
+  *v = strtod(token, &stop);
+  if (len == 0 || *stop != '\0' || !(s->p + len == s->end || is_space(s->p[len]))) {
+    set_graph_error("%s:%ld: invalid %s '%s'", s->path, s->line, what, token);
+    return false;
+  }
+  s->p += len;
+  return true;
+}
+
+// Line-oriented text is parsed by regions of whole lines: a mapped file
+// is one region, a stream (pipe, stdin) is read by blocks of STREAM_BLOCK
+// bytes. A region is cut into chunks at newlines; a first parallel pass
+// counts lines and records per chunk, which gives each chunk its first
+// line number and record index, then a second pass parses all chunks in
+// parallel. Records are non-blank lines (blank ones too if asked), except
+// comment lines.
+#define CHUNK_MIN (1 << 20)
+#define STREAM_BLOCK (8 << 20)
+
+typedef struct TextChunk {
+  const char* begin;
+  const char* end;
+  long first_line, lines;
+  long first_record, records;
+  int64_t* items; //values collected for the caller, in line order
+  long nb_items, max_items;
+  char error[256]; //empty if parsed fine
+} TextChunk;
+
+typedef struct LineParser LineParser;
+struct LineParser {
+  const char* path;
+  const char* comments; //characters starting a comment line
+  bool blank_records;
+  // Header lines from begin: returns the position after them, or NULL
+  const char* (*header)(LineParser* lp, const char* begin, const char* end,
+                        size_t file_len);
+  // Parse record r on the line [s->p, s->end)
+  bool (*parse)(LineParser* lp, Scanner* s, long r, TextChunk* c);
+  // Called in order on each chunk of a region after parsing (optional)
+  void (*collect)(LineParser* lp, TextChunk* c);
+  void* ctx;
+  TextChunk* chunks;
+  long line, record; //next line number and record index
+};
+
+static inline void push_item(TextChunk* c, int64_t v)
+{
+  if (c->nb_items == c->max_items) {
+    c->max_items = (c->max_items == 0 ? 4096 : 2 * c->max_items);
+    c->items = realloc(c->items, c->max_items * sizeof(int64_t));
+  }
+  c->items[c->nb_items++] = v;
+}
+
+// Line [p, eol) kind: 0 blank, 1 comment, 2 data
+static inline int line_kind(const LineParser* lp, const char* p,
+                            const char* eol)
+{
+  while (p < eol && is_space(*p))
+    p++;
+  if (p == eol)
+    return 0;
+  return (lp->comments != NULL && strchr(lp->comments, *p) != NULL ? 1 : 2);
+}
+
+static inline bool is_record(const LineParser* lp, int kind)
+{
+  return kind == 2 || (kind == 0 && lp->blank_records);
+}
+
+static void count_chunk(void* ctx, int t)
+{
+  LineParser* lp = ctx;
+  TextChunk* c = &lp->chunks[t];
+  long lines = 0, records = 0;
+  for (const char* p = c->begin; p < c->end; ) {
+    const char* eol = memchr(p, '\n', c->end - p);
+    if (eol == NULL)
+      eol = c->end;
+    else
+      lines++;
+    records += is_record(lp, line_kind(lp, p, eol));
+    p = eol + 1;
+  }
+  c->lines = lines;
+  c->records = records;
+}
+
+static void parse_chunk(void* ctx, int t)
+{
+  LineParser* lp = ctx;
+  TextChunk* c = &lp->chunks[t];
+  Scanner s = {.line = c->first_line, .path = lp->path};
+  long r = c->first_record;
+  for (const char* p = c->begin; p < c->end; s.line++) {
+    const char* eol = memchr(p, '\n', c->end - p);
+    s.p = p;
+    s.end = (eol != NULL ? eol : c->end);
+    if (is_record(lp, line_kind(lp, s.p, s.end)) &&
+        !lp->parse(lp, &s, r++, c)) {
+      //error message is thread-local: keep it with the chunk
+      snprintf(c->error, sizeof(c->error), "%s", graph_error());
+      return;
+    }
+    p = s.end + 1;
+  }
+}
+
+// Parse the whole lines in [begin, end)
+static bool parse_region(LineParser* lp, const char* begin, const char* end)
+{
+  size_t len = end - begin;
+  int nb_chunks = 4 * get_num_threads();
+  if ((size_t)nb_chunks > len / CHUNK_MIN)
+    nb_chunks = (int)(len / CHUNK_MIN);
+  if (nb_chunks < 1)
+    nb_chunks = 1;
+  TextChunk* chunks = calloc(nb_chunks, sizeof(TextChunk));
+  const char* p = begin;
+  for (int t = 0; t < nb_chunks; t++) {
+    chunks[t].begin = p;
+    const char* q = (t == nb_chunks - 1 ? end : begin + len * (t + 1) / nb_chunks);
+    if (q < p)
+      q = p;
+    if (q < end) {
+      const char* eol = memchr(q, '\n', end - q);
+      q = (eol != NULL ? eol + 1 : end);
+    }
+    chunks[t].end = p = q;
+  }
+  lp->chunks = chunks;
+  parallel_for(nb_chunks, count_chunk, lp);
+  for (int t = 0; t < nb_chunks; t++) {
+    chunks[t].first_line = lp->line;
+    chunks[t].first_record = lp->record;
+    lp->line += chunks[t].lines;
+    lp->record += chunks[t].records;
+  }
+  parallel_for(nb_chunks, parse_chunk, lp);
+  bool ok = true;
+  for (int t = 0; t < nb_chunks; t++) {
+    if (ok && chunks[t].error[0] != '\0') {
+      set_graph_error("%s", chunks[t].error);
+      ok = false;
+    }
+    if (ok && lp->collect != NULL)
+      lp->collect(lp, &chunks[t]);
+    free(chunks[t].items);
+  }
+  free(chunks);
+  lp->chunks = NULL;
+  return ok;
+}
+
+// Regular file: map it and parse everything as one region
+static bool read_mapped(LineParser* lp, int fd, size_t len)
+{
+  char* data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    set_graph_error("cannot map %s", lp->path);
+    return false;
+  }
+  madvise(data, len, MADV_SEQUENTIAL);
+  const char* p = lp->header(lp, data, data + len, len);
+  bool ok = p != NULL && parse_region(lp, p, data + len);
+  munmap(data, len);
+  return ok;
+}
+
+// Pipe or terminal: memory is bounded by one block (plus the graph).
+// The header must fit in the first block.
+static bool read_stream(LineParser* lp, int fd)
+{
+  size_t capacity = STREAM_BLOCK, len = 0;
+  char* buf = malloc(capacity);
+  bool header = false, ok = true, eof = false;
+  while (ok && !eof) {
+    // Fill the block (pipes deliver a few KiB per read)
+    ssize_t k = 1;
+    while (len < capacity) {
+      k = read(fd, buf + len, capacity - len);
+      if (k < 0 && errno == EINTR)
+        continue; //interrupted by a signal: nothing read
+      if (k <= 0)
+        break;
+      len += k;
+    }
+    if (k < 0) {
+      set_graph_error("read error on %s", lp->path);
+      ok = false;
+      break;
+    }
+    eof = (k == 0);
+    // Whole lines only, unless at end of input
+    char* stop = buf + len;
+    if (!eof) {
+      while (stop > buf && stop[-1] != '\n')
+        stop--;
+      if (stop == buf) {
+        if (len == capacity) {
+          //a single line longer than the block
+          capacity *= 2;
+          buf = realloc(buf, capacity);
+        }
+        continue;
+      }
+    }
+    const char* p = buf;
+    if (!header) {
+      p = lp->header(lp, buf, stop, 0);
+      ok = header = (p != NULL);
+    }
+    ok = ok && parse_region(lp, p, stop);
+    len = buf + len - stop;
+    memmove(buf, stop, len);
+  }
+  free(buf);
+  return ok;
+}
+
+// Open path ("-" for stdin) and run the parser on it
+static bool read_lines(LineParser* lp, const char* path)
+{
+  bool is_stdin = (strcmp(path, "-") == 0);
+  int fd = (is_stdin ? STDIN_FILENO : open(path, O_RDONLY));
+  lp->path = (is_stdin ? "<stdin>" : path);
+  lp->line = 1;
+  lp->record = 0;
+  if (fd < 0) {
+    set_graph_error("cannot read %s", path);
+    return false;
+  }
+  struct stat st;
+  bool ok;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    ok = read_mapped(lp, fd, st.st_size);
+  else
+    ok = read_stream(lp, fd);
+  if (!is_stdin)
+    close(fd);
+  return ok;
+}
+
+// Next line from p (blank and comment lines skipped if asked):
+// bounds in s, returns the position after it
+static const char* header_line(LineParser* lp, Scanner* s, const char* p,
+                               const char* end, bool skip_comments)
+{
+  while (true) {
+    const char* eol = memchr(p, '\n', end - p);
+    s->p = p;
+    s->end = (eol != NULL ? eol : end);
+    s->line = lp->line++;
+    s->path = lp->path;
+    p = (eol != NULL ? eol + 1 : end);
+    if (!skip_comments || line_kind(lp, s->p, s->end) == 2 || p == end)
+      return p;
+  }
+}
+
+static Graph finish_graph(Graph* g, int* edges, long m, bool ok)
+{
+  if (ok)
+    build_adjacency(g, edges, m);
+  free(edges);
+  if (!ok) {
+    free_graph(*g);
+    return bad_graph();
+  }
+  return *g;
+}
+
+/////////////////////////////
+// grem text format
+/////////////////////////////
+
+// Record r is node r if r < n, edge r - n otherwise: each chunk writes at
+// known indices, no merge needed.
+typedef struct GremText {
+  Graph* g;
+  int* edges;
+  long n, m;
+} GremText;
+
+static const char* grem_header(LineParser* lp, const char* begin,
+                               const char* end, size_t file_len)
+{
+  GremText* gt = lp->ctx;
+  Scanner s;
+  const char* next = header_line(lp, &s, begin, end, false);
+  int n, m;
+  if (!scan_int(&s, &n, "number of nodes") ||
+      !scan_int(&s, &m, "number of edges"))
+    return NULL;
+  if (n < 0 || m < 0 || skip_spaces(&s)) {
+    set_graph_error("%s:1: expected \"n m\" header", lp->path);
+    return NULL;
+  }
+  // Each node line takes at least 6 bytes, each edge line 4
+  if (file_len > 0 && ((size_t)n > file_len / 6 || (size_t)m > file_len / 4)) {
+    set_graph_error("%s:1: sizes %d %d do not fit in the file", lp->path, n, m);
+    return NULL;
+  }
+  gt->n = n;
+  gt->m = m;
+  re_init_nodes(gt->g, n, 0.0, NULL);
+  gt->edges = malloc(2 * (size_t)m * sizeof(int) + 1);
+  if (gt->edges == NULL) {
+    set_graph_error("%s:1: not enough memory for %d edges", lp->path, m);
+    return NULL;
+  }
+  return next;
+}
+
+static bool grem_record(LineParser* lp, Scanner* s, long r, TextChunk* c)
+{
+  GremText* gt = lp->ctx;
+  if (r < gt->n) {
+    Graph* g = gt->g;
+    if (!scan_double(s, &g->x[r], "x coordinate") ||
+        !scan_double(s, &g->y[r], "y coordinate") ||
+        !scan_int(s, &g->color[r], "color"))
+      return false;
+  }
+  else if (r < gt->n + gt->m) {
+    int* e = &gt->edges[2 * (r - gt->n)];
+    for (int k = 0; k < 2; k++) {
+      if (!scan_int(s, &e[k], "node index"))
+        return false;
+      if (e[k] < 0 || e[k] >= gt->n) {
+        set_graph_error("%s:%ld: node index %d out of range [0, %ld)",
+                  s->path, s->line, e[k], gt->n);
+        return false;
+      }
+    }
+  }
+  else {
+    set_graph_error("%s:%ld: unexpected data after %ld edges",
+              s->path, s->line, gt->m);
+    return false;
+  }
+  if (skip_spaces(s)) {
+    set_graph_error("%s:%ld: unexpected data at end of line", s->path, s->line);
+    return false;
+  }
+  return true;
+}
+
+Graph read_graph(char* path)
+{
+  Graph g;
+  init_graph(&g);
+  GremText gt = {.g = &g};
+  LineParser lp = {.header = grem_header, .parse = grem_record, .ctx = &gt};
+  bool ok = read_lines(&lp, path);
+  if (ok && lp.record < gt.n + gt.m) {
+    set_graph_error("%s:%ld: missing records: %ld nodes and %ld edges expected",
+              lp.path, lp.line, gt.n, gt.m);
+    ok = false;
+  }
+  return finish_graph(&g, gt.edges, gt.m, ok);
+}
+
+/////////////////////////////
+// Importers
+/////////////////////////////
+
+// Edges collected by chunks (pairs of 0-based indices), in file order
+typedef struct EdgeBuffer {
+  int* edges;
+  long m, max_m;
+} EdgeBuffer;
+
+static void append_edges(EdgeBuffer* eb, const int64_t* items, long nb)
+{
+  if (eb->m + nb / 2 > eb->max_m) {
+    while (eb->max_m < eb->m + nb / 2)
+      eb->max_m = (eb->max_m == 0 ? 4096 : 2 * eb->max_m);
+    eb->edges = realloc(eb->edges, 2 * eb->max_m * sizeof(int));
+  }
+  for (long k = 0; k < nb; k++)
+    eb->edges[2 * eb->m + k] = (int)items[k];
+  eb->m += nb / 2;
+}
+
+// Imported graph: random positions, adjacency without loops nor multiple
+// edges
+static Graph finish_import(Graph* g, EdgeBuffer* eb, bool ok)
+{
+  *g = finish_graph(g, eb->edges, eb->m, ok);
+  if (ok)
+    simplify_graph(g);
+  return *g;
+}
+
+// Hash map from file ids to node indices, by order of appearance
+typedef struct IdMap {
+  int64_t* keys;
+  int* values; //-1 if empty
+  size_t mask;
+  int64_t* ids; //ids[i] = key of node i
+  int n, max_n;
+} IdMap;
+
+static inline size_t hash_id(int64_t key)
+{
+  uint64_t z = (uint64_t)key + 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return (size_t)(z ^ (z >> 31));
+}
+
+static void idmap_resize(IdMap* map, size_t size)
+{
+  map->keys = realloc(map->keys, size * sizeof(int64_t));
+  map->values = realloc(map->values, size * sizeof(int));
+  map->mask = size - 1;
+  for (size_t k = 0; k < size; k++)
+    map->values[k] = -1;
+  // Reinsert from the ids list
+  for (int i = 0; i < map->n; i++) {
+    size_t k = hash_id(map->ids[i]) & map->mask;
+    while (map->values[k] >= 0)
+      k = (k + 1) & map->mask;
+    map->keys[k] = map->ids[i];
+    map->values[k] = i;
+  }
+}
+
+static int idmap_get(IdMap* map, int64_t key)
+{
+  size_t k = hash_id(key) & map->mask;
+  while (map->values[k] >= 0) {
+    if (map->keys[k] == key)
+      return map->values[k];
+    k = (k + 1) & map->mask;
+  }
+  if (map->n == INT32_MAX)
+    return -1;
+  if (map->n == map->max_n) {
+    map->max_n *= 2;
+    map->ids = realloc(map->ids, map->max_n * sizeof(int64_t));
+  }
+  map->ids[map->n] = key;
+  map->keys[k] = key;
+  map->values[k] = map->n;
+  if (++map->n > (int)(map->mask / 2))
+    idmap_resize(map, 2 * (map->mask + 1));
+  return map->n - 1;
+}
+
+typedef struct EdgeListText {
+  IdMap map;
+  EdgeBuffer eb;
+  bool overflow;
+} EdgeListText;
+
+static const char* no_header(LineParser* lp, const char* begin,
+                             const char* end, size_t file_len)
+{
+  return begin;
+}
+
+static bool edge_list_record(LineParser* lp, Scanner* s, long r, TextChunk* c)
+{
+  int64_t u, v;
+  if (!scan_id(s, &u, "node id") || !scan_id(s, &v, "node id"))
+    return false;
+  //further columns (weights, timestamps...) are ignored
+  push_item(c, u);
+  push_item(c, v);
+  return true;
+}
+
+// Ids are remapped sequentially, chunk after chunk: numbering follows
+// the order of first appearance in the file
+static void collect_edge_list(LineParser* lp, TextChunk* c)
+{
+  EdgeListText* el = lp->ctx;
+  for (long k = 0; k < c->nb_items; k++) {
+    int i = idmap_get(&el->map, c->items[k]);
+    el->overflow |= (i < 0);
+    c->items[k] = i;
+  }
+  append_edges(&el->eb, c->items, c->nb_items);
+}
+
+Graph read_edge_list(char* path, double width, int seed, long long** ids)
+{
+  EdgeListText el = {.map = {.max_n = 1024}};
+  el.map.ids = malloc(el.map.max_n * sizeof(int64_t));
+  idmap_resize(&el.map, 2048);
+  LineParser lp = {.comments = "#%", .header = no_header,
+                   .parse = edge_list_record, .collect = collect_edge_list,
+                   .ctx = &el};
+  bool ok = read_lines(&lp, path);
+  if (ok && el.overflow) {
+    set_graph_error("%s: too many distinct node ids", lp.path);
+    ok = false;
+  }
+  Rng rng;
+  rng_init(&rng, seed);
+  Graph g;
+  init_graph(&g);
+  if (ok)
+    re_init_nodes(&g, el.map.n, width, &rng);
+  if (ok && ids != NULL) {
+    *ids = malloc(el.map.n * sizeof(long long) + 1);
+    for (int i = 0; i < el.map.n; i++)
+      (*ids)[i] = el.map.ids[i];
+  }
+  free(el.map.keys);
+  free(el.map.values);
+  free(el.map.ids);
+  return finish_import(&g, &el.eb, ok);
+}
+
+typedef struct SquareText {
+  Graph* g;
+  double width;
+  Rng rng;
+  long n, nb_entries;
+  int ncon; //METIS: vertex weights per node
+  bool vsize, ewgt; //METIS: vertex sizes, edge weights
+  EdgeBuffer eb;
+} SquareText;
+
+// Case-insensitive comparison of a token with a keyword
+static bool token_is(const char* p, const char* end, const char* word)
+{
+  size_t len = strlen(word);
+  if ((size_t)(end - p) < len || (p + len < end && !is_space(p[len])))
+    return false;
+  for (size_t k = 0; k < len; k++) {
+    char c = p[k];
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    if (c != word[k])
+      return false;
+  }
+  return true;
+}
+
+// Start of the k-th token of the line in s (or NULL)
+static const char* nth_token(Scanner* s, int k)
+{
+  Scanner t = *s;
+  for (int i = 0; skip_spaces(&t); i++) {
+    if (i == k)
+      return t.p;
+    while (t.p < t.end && !is_space(*t.p))
+      t.p++;
+  }
+  return NULL;
+}
+
+static const char* mm_header(LineParser* lp, const char* begin,
+                             const char* end, size_t file_len)
+{
+  SquareText* st = lp->ctx;
+  Scanner s;
+  const char* next = header_line(lp, &s, begin, end, false);
+  const char* obj = nth_token(&s, 1), *fmt = nth_token(&s, 2);
+  if (!token_is(s.p, s.end, "%%matrixmarket") || obj == NULL ||
+      !token_is(obj, s.end, "matrix") || fmt == NULL) {
+    set_graph_error("%s:1: not a Matrix Market matrix", lp->path);
+    return NULL;
+  }
+  if (!token_is(fmt, s.end, "coordinate")) {
+    set_graph_error("%s:1: only the coordinate (sparse) format is supported",
+              lp->path);
+    return NULL;
+  }
+  next = header_line(lp, &s, next, end, true);
+  int rows, cols;
+  int64_t nnz;
+  if (!scan_int(&s, &rows, "number of rows") ||
+      !scan_int(&s, &cols, "number of columns") ||
+      !scan_id(&s, &nnz, "number of entries"))
+    return NULL;
+  if (rows != cols || rows < 0 || nnz < 0) {
+    set_graph_error("%s:%ld: expected a square matrix, got %d x %d",
+              lp->path, s.line, rows, cols);
+    return NULL;
+  }
+  st->n = rows;
+  st->nb_entries = nnz;
+  re_init_nodes(st->g, rows, st->width, &st->rng);
+  return next;
+}
+
+static bool mm_record(LineParser* lp, Scanner* s, long r, TextChunk* c)
+{
+  SquareText* st = lp->ctx;
+  int ij[2];
+  for (int k = 0; k < 2; k++) {
+    if (!scan_int(s, &ij[k], "index"))
+      return false;
+    if (ij[k] < 1 || ij[k] > st->n) {
+      set_graph_error("%s:%ld: index %d out of range [1, %ld]",
+                s->path, s->line, ij[k], st->n);
+      return false;
+    }
+  }
+  //values are ignored
+  if (ij[0] != ij[1]) {
+    push_item(c, ij[0] - 1);
+    push_item(c, ij[1] - 1);
+  }
+  return true;
+}
+
+static void collect_square(LineParser* lp, TextChunk* c)
+{
+  SquareText* st = lp->ctx;
+  append_edges(&st->eb, c->items, c->nb_items);
+}
+
+Graph read_matrix_market(char* path, double width, int seed)
+{
+  Graph g;
+  init_graph(&g);
+  SquareText st = {.g = &g, .width = width};
+  rng_init(&st.rng, seed);
+  LineParser lp = {.comments = "%", .header = mm_header, .parse = mm_record,
+                   .collect = collect_square, .ctx = &st};
+  bool ok = read_lines(&lp, path);
+  if (ok && lp.record != st.nb_entries) {
+    set_graph_error("%s:%ld: %ld entries found, %ld expected",
+              lp.path, lp.line, lp.record, st.nb_entries);
+    ok = false;
+  }
+  return finish_import(&g, &st.eb, ok);
+}
+
+// METIS: "n m [fmt [ncon]]", then line i lists the neighbors of node i
+// (1-based), possibly after its size and weights; fmt digits tell which
+// of vertex sizes, vertex weights and edge weights are present.
+static const char* metis_header(LineParser* lp, const char* begin,
+                                const char* end, size_t file_len)
+{
+  SquareText* st = lp->ctx;
+  Scanner s;
+  const char* next = header_line(lp, &s, begin, end, true);
+  int n, m, fmt = 0, ncon = 1;
+  if (!scan_int(&s, &n, "number of nodes") ||
+      !scan_int(&s, &m, "number of edges") ||
+      (skip_spaces(&s) && !scan_int(&s, &fmt, "format")) ||
+      (skip_spaces(&s) && !scan_int(&s, &ncon, "number of weights")))
+    return NULL;
+  if (n < 0 || m < 0 || ncon < 0 || fmt < 0 || fmt > 111 || skip_spaces(&s)) {
+    set_graph_error("%s:%ld: expected \"n m [fmt [ncon]]\" header",
+              lp->path, s.line);
+    return NULL;
+  }
+  st->n = n;
+  st->nb_entries = m;
+  st->vsize = (fmt / 100 == 1);
+  st->ncon = ((fmt / 10) % 10 == 1 ? ncon : 0);
+  st->ewgt = (fmt % 10 == 1);
+  re_init_nodes(st->g, n, st->width, &st->rng);
+  return next;
+}
+
+static bool metis_record(LineParser* lp, Scanner* s, long r, TextChunk* c)
+{
+  SquareText* st = lp->ctx;
+  if (r >= st->n) {
+    if (skip_spaces(s)) {
+      set_graph_error("%s:%ld: unexpected data after %ld nodes",
+                s->path, s->line, st->n);
+      return false;
+    }
+    return true; //trailing blank line
+  }
+  int v, w;
+  if (st->vsize && !scan_int(s, &w, "vertex size"))
+    return false;
+  for (int k = 0; k < st->ncon; k++) {
+    if (!scan_int(s, &w, "vertex weight"))
+      return false;
+  }
+  while (skip_spaces(s)) {
+    if (!scan_int(s, &v, "neighbor"))
+      return false;
+    if (v < 1 || v > st->n) {
+      set_graph_error("%s:%ld: neighbor %d out of range [1, %ld]",
+                s->path, s->line, v, st->n);
+      return false;
+    }
+    if (st->ewgt && !scan_int(s, &w, "edge weight"))
+      return false;
+    // Each edge appears on both lines: keep it once
+    if (r < v - 1) {
+      push_item(c, r);
+      push_item(c, v - 1);
+    }
+  }
+  return true;
+}
+
+Graph read_metis(char* path, double width, int seed)
+{
+  Graph g;
+  init_graph(&g);
+  SquareText st = {.g = &g, .width = width};
+  rng_init(&st.rng, seed);
+  LineParser lp = {.comments = "%", .blank_records = true,
+                   .header = metis_header, .parse = metis_record,
+                   .collect = collect_square, .ctx = &st};
+  bool ok = read_lines(&lp, path);
+  if (ok && lp.record < st.n) {
+    set_graph_error("%s:%ld: %ld node lines found, %ld expected",
+              lp.path, lp.line, lp.record, st.n);
+    ok = false;
+  }
+  if (ok && st.eb.m != st.nb_entries) {
+    set_graph_error("%s: %ld edges found, %ld expected (asymmetric adjacency?)",
+              lp.path, st.eb.m, st.nb_entries);
+    ok = false;
+  }
+  return finish_import(&g, &st.eb, ok);
+}
+
+/////////////////////////////
+// Binary format
+/////////////////////////////
+
+enum {SEC_POS=0, SEC_COLOR, SEC_SIZE, SEC_DEGREE, SEC_OFFSETS, SEC_TARGETS,
+      NB_SECTIONS};
+
+typedef struct BinHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  int64_t n;
+  int64_t capacity; //y = x + capacity (multiple of 8)
+  int64_t nb_targets; //sum of degrees
+  uint64_t file_size;
+  uint64_t section[NB_SECTIONS]; //byte offsets from file start
+} BinHeader;
+
+static uint64_t align_up(uint64_t v)
+{
+  return (v + BIN_ALIGN - 1) & ~(uint64_t)(BIN_ALIGN - 1);
+}
+
+// Fill sizes and offsets for n nodes and nb_targets adjacency cells
+static void bin_layout(BinHeader* h, int64_t n, int64_t nb_targets)
+{
+  memset(h, 0, sizeof(BinHeader));
+  memcpy(h->magic, BIN_MAGIC, 8);
+  h->version = BIN_VERSION;
+  h->header_size = BIN_HEADER_SIZE;
+  h->n = n;
+  h->capacity = (n + 7) & ~(int64_t)7;
+  h->nb_targets = nb_targets;
+  uint64_t bytes[NB_SECTIONS] = {
+    2 * h->capacity * sizeof(double),
+    n * sizeof(int32_t),
+    n * sizeof(int32_t),
+    n * sizeof(int32_t),
+    (n + 1) * sizeof(int64_t),
+    nb_targets * sizeof(int32_t)
+  };
+  uint64_t pos = BIN_HEADER_SIZE;
+  for (int s = 0; s < NB_SECTIONS; s++) {
+    h->section[s] = pos;
+    pos = align_up(pos + bytes[s]);
+  }
+  h->file_size = pos;
+}
+
+static bool write_zeros(FILE* f, size_t count)
+{
+  static const char zeros[BIN_ALIGN] = {0};
+  while (count > 0) {
+    size_t k = (count < BIN_ALIGN ? count : BIN_ALIGN);
+    if (fwrite(zeros, 1, k, f) != k)
+      return false;
+    count -= k;
+  }
+  return true;
+}
+
+// Write bytes, then zeros up to the aligned end of a section of given size
+static bool write_padded(FILE* f, const void* data, size_t bytes, size_t size)
+{
+  if (bytes > 0 && fwrite(data, 1, bytes, f) != bytes)
+    return false;
+  return write_zeros(f, align_up(size) - bytes);
+}
+
+int write_graph_binary(const Graph* g, const char* path)
+{
+  int64_t n = g->n, nb_targets = 0;
+  int64_t* offsets = malloc((n + 1) * sizeof(int64_t));
+  offsets[0] = 0;
+  for (int i = 0; i < n; i++)
+    offsets[i+1] = offsets[i] + g->degree[i];
+  nb_targets = offsets[n];
+  BinHeader h;
+  bin_layout(&h, n, nb_targets);
+  FILE* f = fopen(path, "wb");
+  if (f == NULL) {
+    set_graph_error("cannot open %s for writing", path);
+    free(offsets);
+    return -1;
+  }
+  char header[BIN_HEADER_SIZE] = {0};
+  memcpy(header, &h, sizeof(BinHeader));
+  bool ok = fwrite(header, 1, BIN_HEADER_SIZE, f) == BIN_HEADER_SIZE;
+  // x and y padded to capacity each, then the int arrays
+  size_t pos_bytes = h.capacity * sizeof(double);
+  ok = ok && write_padded(f, g->x, n * sizeof(double), pos_bytes);
+  ok = ok && write_padded(f, g->y, n * sizeof(double), pos_bytes);
+  ok = ok && write_padded(f, g->color, n * sizeof(int), n * sizeof(int));
+  ok = ok && write_padded(f, g->size, n * sizeof(int), n * sizeof(int));
+  ok = ok && write_padded(f, g->degree, n * sizeof(int), n * sizeof(int));
+  ok = ok && write_padded(f, offsets, (n + 1) * sizeof(int64_t),
+                          (n + 1) * sizeof(int64_t));
+  for (int i = 0; ok && i < n; i++) {
+    size_t bytes = g->degree[i] * sizeof(int);
+    ok = bytes == 0 || fwrite(g->neighbors[i], 1, bytes, f) == bytes;
+  }
+  size_t tb = nb_targets * sizeof(int);
+  ok = ok && write_zeros(f, align_up(tb) - tb);
+  ok = (fclose(f) == 0) && ok;
+  free(offsets);
+  if (!ok) {
+    set_graph_error("write error on %s", path);
+    return -1;
+  }
+  return 0;
+}
+
+// Check header fields against what the layout would be, and file size
+static bool check_header(const BinHeader* h, uint64_t file_size,
+                         const char* path)
+{
+  if (memcmp(h->magic, BIN_MAGIC, 8) != 0) {
+    set_graph_error("%s: not a binary graph file", path);
+    return false;
+  }
+  if (h->version != BIN_VERSION) {
+    set_graph_error("%s: unsupported version %u", path, h->version);
+    return false;
+  }
+  if (h->n < 0 || h->n > INT32_MAX || h->nb_targets < 0) {
+    set_graph_error("%s: invalid sizes in header", path);
+    return false;
+  }
+  BinHeader ref;
+  bin_layout(&ref, h->n, h->nb_targets);
+  if (h->header_size != BIN_HEADER_SIZE || h->capacity != ref.capacity ||
+      memcmp(h->section, ref.section, sizeof(ref.section)) != 0) {
+    set_graph_error("%s: inconsistent section offsets", path);
+    return false;
+  }
+  if (file_size < ref.file_size) {
+    set_graph_error("%s: truncated file (%llu bytes, expected %llu)", path,
+              (unsigned long long)file_size,
+              (unsigned long long)ref.file_size);
+    return false;
+  }
+  return true;
+}
+
+// Link neighbors[i] into targets, checking offsets against degrees
+static bool link_neighbors(Graph* g, const int64_t* offsets, int* targets,
+                           int64_t nb_targets, const char* path)
+{
+  if (offsets[0] != 0 || offsets[g->n] != nb_targets) {
+    set_graph_error("%s: invalid CSR offsets", path);
+    return false;
+  }
+  for (int i = 0; i < g->n; i++) {
+    if (g->degree[i] < 0 || offsets[i+1] - offsets[i] != g->degree[i]) {
+      set_graph_error("%s: degree of node %d does not match offsets", path, i);
+      return false;
+    }
+    g->neighbors[i] = (g->degree[i] > 0 ? targets + offsets[i] : NULL);
+  }
+  return true;
+}
+
+static bool check_targets(const int* targets, int64_t nb_targets, int n,
+                          const char* path)
+{
+  for (int64_t k = 0; k < nb_targets; k++) {
+    if (targets[k] < 0 || targets[k] >= n) {
+      set_graph_error("%s: neighbor index %d out of range", path, targets[k]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool read_at(FILE* f, uint64_t offset, void* data, size_t bytes)
+{
+  return bytes == 0 ||
+    (fseek(f, (long)offset, SEEK_SET) == 0 && fread(data, 1, bytes, f) == bytes);
+}
+
+Graph read_graph_binary(const char* path)
+{
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    set_graph_error("cannot open %s", path);
+    return bad_graph();
+  }
+  BinHeader h;
+  fseek(f, 0, SEEK_END);
+  uint64_t file_size = ftell(f);
+  bool ok = file_size >= sizeof(BinHeader) &&
+    read_at(f, 0, &h, sizeof(BinHeader));
+  if (!ok)
+    set_graph_error("%s: not a binary graph file", path);
+  if (!ok || !check_header(&h, file_size, path)) {
+    fclose(f);
+    return bad_graph();
+  }
+  int n = (int)h.n;
+  Graph g;
+  init_graph(&g);
+  re_init_nodes(&g, n, 0.0, NULL);
+  int64_t* offsets = malloc((n + 1) * sizeof(int64_t));
+  int* targets = arena_alloc(g.arena, h.nb_targets * sizeof(int));
+  ok =
+    read_at(f, h.section[SEC_POS], g.x, n * sizeof(double)) &&
+    read_at(f, h.section[SEC_POS] + h.capacity * sizeof(double), g.y,
+            n * sizeof(double)) &&
+    read_at(f, h.section[SEC_COLOR], g.color, n * sizeof(int)) &&
+    read_at(f, h.section[SEC_SIZE], g.size, n * sizeof(int)) &&
+    read_at(f, h.section[SEC_DEGREE], g.degree, n * sizeof(int)) &&
+    read_at(f, h.section[SEC_OFFSETS], offsets, (n + 1) * sizeof(int64_t)) &&
+    read_at(f, h.section[SEC_TARGETS], targets, h.nb_targets * sizeof(int));
+  fclose(f);
+  if (!ok)
+    set_graph_error("read error on %s", path);
+  ok = ok && link_neighbors(&g, offsets, targets, h.nb_targets, path);
+  free(offsets);
+  // A copy can afford a full check
+  ok = ok && check_targets(targets, h.nb_targets, n, path);
+  if (!ok) {
+    free_graph(g);
+    return bad_graph();
+  }
+  return g;
+}
+
+// Point g (fresh, owning base in its arena) into a checked binary image
+static bool bind_binary(Graph* g, const BinHeader* h, char* base,
+                        const char* name)
+{
+  g->n = (int)h->n;
+  g->capacity = (int)h->capacity;
+  g->x = (double*)(base + h->section[SEC_POS]);
+  g->y = g->x + g->capacity;
+  g->color = (int*)(base + h->section[SEC_COLOR]);
+  g->size = (int*)(base + h->section[SEC_SIZE]);
+  g->degree = (int*)(base + h->section[SEC_DEGREE]);
+  // Layout buffers and the pointers array are the only allocations
+  g->dx = arena_alloc_aligned(g->arena, 2 * g->capacity * sizeof(double),
+                              BIN_ALIGN);
+  g->dy = g->dx + g->capacity;
+  memset(g->dx, 0, 2 * g->capacity * sizeof(double));
+  g->neighbors = arena_alloc(g->arena, g->capacity * sizeof(int*));
+  return link_neighbors(g, (int64_t*)(base + h->section[SEC_OFFSETS]),
+                        (int*)(base + h->section[SEC_TARGETS]), h->nb_targets,
+                        name);
+}
+
+// Private writable mapping of fd (closed here): layouts may move nodes,
+// the file or shared memory object stays intact
+static Graph map_binary_fd(int fd, const char* name)
+{
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(BinHeader)) {
+    set_graph_error("%s: not a binary graph file", name);
+    close(fd);
+    return bad_graph();
+  }
+  size_t len = st.st_size;
+  char* base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    set_graph_error("cannot map %s", name);
+    return bad_graph();
+  }
+  BinHeader h;
+  memcpy(&h, base, sizeof(BinHeader));
+  if (!check_header(&h, len, name)) {
+    munmap(base, len);
+    return bad_graph();
+  }
+  Graph g;
+  init_graph(&g);
+  arena_attach_mapping(g.arena, base, len);
+  // Targets are checked too (one sequential pass over them): corrupt
+  // indices would crash any later traversal
+  if (!bind_binary(&g, &h, base, name) ||
+      !check_targets((int*)(base + h.section[SEC_TARGETS]), h.nb_targets,
+                     g.n, name)) {
+    free_graph(g);
+    return bad_graph();
+  }
+  return g;
+}
+
+Graph map_graph_binary(const char* path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    set_graph_error("cannot open %s", path);
+    return bad_graph();
+  }
+  return map_binary_fd(fd, path);
+}
+
+// In-memory images
+/////////////////////////////
+
+size_t graph_binary_size(const Graph* g)
+{
+  int64_t nb_targets = 0;
+  for (int i = 0; i < g->n; i++)
+    nb_targets += g->degree[i];
+  BinHeader h;
+  bin_layout(&h, g->n, nb_targets);
+  return h.file_size;
+}
+
+// Same bytes as write_graph_binary() into base (h->file_size bytes)
+static void fill_binary(const Graph* g, const BinHeader* h, char* base)
+{
+  int64_t n = h->n;
+  memset(base, 0, BIN_HEADER_SIZE);
+  memcpy(base, h, sizeof(BinHeader));
+  double* pos = (double*)(base + h->section[SEC_POS]);
+  memset(pos, 0, 2 * h->capacity * sizeof(double));
+  memcpy(pos, g->x, n * sizeof(double));
+  memcpy(pos + h->capacity, g->y, n * sizeof(double));
+  memcpy(base + h->section[SEC_COLOR], g->color, n * sizeof(int));
+  memcpy(base + h->section[SEC_SIZE], g->size, n * sizeof(int));
+  memcpy(base + h->section[SEC_DEGREE], g->degree, n * sizeof(int));
+  int64_t* offsets = (int64_t*)(base + h->section[SEC_OFFSETS]);
+  int* targets = (int*)(base + h->section[SEC_TARGETS]);
+  offsets[0] = 0;
+  for (int i = 0; i < n; i++) {
+    if (g->degree[i] > 0)
+      memcpy(targets + offsets[i], g->neighbors[i], g->degree[i] * sizeof(int));
+    offsets[i+1] = offsets[i] + g->degree[i];
+  }
+  // Padding after each int section, up to the next one (or the end)
+  uint64_t ends[NB_SECTIONS] = {
+    0, //positions already cleared
+    h->section[SEC_COLOR] + n * sizeof(int),
+    h->section[SEC_SIZE] + n * sizeof(int),
+    h->section[SEC_DEGREE] + n * sizeof(int),
+    h->section[SEC_OFFSETS] + (n + 1) * sizeof(int64_t),
+    h->section[SEC_TARGETS] + h->nb_targets * sizeof(int)
+  };
+  for (int s = 1; s < NB_SECTIONS; s++) {
+    uint64_t next = (s + 1 < NB_SECTIONS ? h->section[s+1] : h->file_size);
+    memset(base + ends[s], 0, next - ends[s]);
+  }
+}
+
+int write_graph_binary_buffer(const Graph* g, void* buf, size_t len)
+{
+  int64_t nb_targets = 0;
+  for (int i = 0; i < g->n; i++)
+    nb_targets += g->degree[i];
+  BinHeader h;
+  bin_layout(&h, g->n, nb_targets);
+  if (len < h.file_size) {
+    set_graph_error("buffer too small (%zu bytes, expected %llu)", len,
+                    (unsigned long long)h.file_size);
+    return -1;
+  }
+  fill_binary(g, &h, buf);
+  return 0;
+}
+
+Graph read_graph_binary_buffer(const void* buf, size_t len)
+{
+  const char* name = "binary buffer";
+  BinHeader h;
+  if (len < sizeof(BinHeader)) {
+    set_graph_error("%s: not a binary graph file", name);
+    return bad_graph();
+  }
+  memcpy(&h, buf, sizeof(BinHeader));
+  if (!check_header(&h, len, name))
+    return bad_graph();
+  // One copy of the image, used in place like a mapping
+  Graph g;
+  init_graph(&g);
+  char* base = arena_alloc_aligned(g.arena, h.file_size, BIN_ALIGN);
+  memcpy(base, buf, h.file_size);
+  bool ok = bind_binary(&g, &h, base, name) &&
+    check_targets((int*)(base + h.section[SEC_TARGETS]), h.nb_targets, g.n,
+                  name);
+  if (!ok) {
+    free_graph(g);
+    return bad_graph();
+  }
+  return g;
+}
+
+// Shared memory
+/////////////////////////////
+
+int share_graph(const Graph* g, const char* name)
+{
+  int64_t nb_targets = 0;
+  for (int i = 0; i < g->n; i++)
+    nb_targets += g->degree[i];
+  BinHeader h;
+  bin_layout(&h, g->n, nb_targets);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    set_graph_error("cannot create shared memory %s", name);
+    return -1;
+  }
+  char* base = MAP_FAILED;
+  if (ftruncate(fd, h.file_size) == 0) {
+    base = mmap(NULL, h.file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    set_graph_error("cannot allocate %llu bytes of shared memory %s",
+                    (unsigned long long)h.file_size, name);
+    shm_unlink(name);
+    return -1;
+  }
+  fill_binary(g, &h, base);
+  munmap(base, h.file_size);
+  return 0;
+}
+
+Graph attach_graph(const char* name)
+{
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    set_graph_error("cannot open shared memory %s", name);
+    return bad_graph();
+  }
+  return map_binary_fd(fd, name);
+}
+
+int unlink_shared_graph(const char* name)
+{
+  if (shm_unlink(name) != 0) {
+    set_graph_error("cannot unlink shared memory %s", name);
+    return -1;
+  }
+  return 0;
+}
+
+/////////////////////////////
+// Compressed format
+/////////////////////////////
+
+// Nodes are encoded by blocks of ZIP_BLOCK, independently: per node,
+// LEB128 varints for degree, first neighbor (zigzag, relative to the
+// node), gaps between sorted neighbors, x and y (quantized, zigzag
+// delta from the previous node; raw float64 if lossless), color and
+// size (zigzag delta from the previous node). A table gives for each
+// block its byte offset and its first adjacency cell, so blocks are
+// encoded and decoded in parallel.
+#define ZIP_MAGIC "GREMZIP"
+#define ZIP_VERSION 1
+#define ZIP_BLOCK 4096
+#define ZIP_LOSSY 1 //flag: quantized positions
+
+typedef struct ZipHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  int64_t n;
+  int64_t nb_targets;
+  int64_t nb_blocks;
+  double step; //quantization step (lossy)
+  double minx, miny; //quantization origin (lossy)
+  uint64_t table; //offset of nb_blocks + 1 ZipEntry
+  uint64_t data; //offset of block data
+  uint64_t file_size;
+} ZipHeader;
+
+typedef struct ZipEntry {
+  uint64_t offset; //from data start
+  int64_t first_target;
+} ZipEntry;
+
+static inline uint64_t zigzag(int64_t v)
+{
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t u)
+{
+  return (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+}
+
+static inline uint8_t* put_varint(uint8_t* p, uint64_t v)
+{
+  while (v >= 0x80) {
+    *p++ = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+// NULL if the varint runs past end or is longer than 10 bytes
+static inline const uint8_t* get_varint(const uint8_t* p, const uint8_t* end,
+                                        uint64_t* v)
+{
+  if (p < end && *p < 0x80) { //most values fit in one byte
+    *v = *p;
+    return p + 1;
+  }
+  uint64_t r = 0;
+  for (int shift = 0; p < end && shift < 70; shift += 7) {
+    uint8_t b = *p++;
+    r |= (uint64_t)(b & 0x7f) << shift;
+    if (b < 0x80) {
+      *v = r;
+      return p;
+    }
+  }
+  return NULL;
+}
+
+typedef struct ZipJob {
+  const Graph* g; //encode
+  Graph* out; //decode
+  ZipHeader h;
+  uint8_t** blocks; //encode: one buffer per block
+  size_t* sizes;
+  const ZipEntry* table; //decode
+  const uint8_t* data;
+  int* targets;
+  bool* failed;
+} ZipJob;
+
+static inline int64_t quantize(double v, double origin, double step)
+{
+  return llround((v - origin) / step);
+}
+
+static void zip_block(void* ctx, int b)
+{
+  ZipJob* job = ctx;
+  const Graph* g = job->g;
+  int i0 = b * ZIP_BLOCK, i1 = (i0 + ZIP_BLOCK < g->n ? i0 + ZIP_BLOCK : g->n);
+  size_t bound = 0;
+  int max_degree = 0;
+  for (int i = i0; i < i1; i++) {
+    bound += 10 * ((size_t)g->degree[i] + 6);
+    if (g->degree[i] > max_degree)
+      max_degree = g->degree[i];
+  }
+  uint8_t* buf = malloc(bound + 1);
+  int* nb = malloc((max_degree + 1) * sizeof(int));
+  uint8_t* p = buf;
+  bool lossy = job->h.flags & ZIP_LOSSY;
+  int64_t qx = 0, qy = 0, color = 0, size = 0;
+  for (int i = i0; i < i1; i++) {
+    int d = g->degree[i];
+    memcpy(nb, g->neighbors[i], d * sizeof(int));
+    sort_ints(nb, d);
+    p = put_varint(p, d);
+    for (int j = 0; j < d; j++)
+      p = put_varint(p, (j == 0 ? zigzag((int64_t)nb[0] - i) : (uint64_t)(nb[j] - nb[j-1])));
+    if (lossy) {
+      int64_t x = quantize(g->x[i], job->h.minx, job->h.step),
+              y = quantize(g->y[i], job->h.miny, job->h.step);
+      p = put_varint(p, zigzag(x - qx));
+      p = put_varint(p, zigzag(y - qy));
+      qx = x;
+      qy = y;
+    }
+    else {
+      memcpy(p, &g->x[i], sizeof(double));
+      memcpy(p + sizeof(double), &g->y[i], sizeof(double));
+      p += 2 * sizeof(double);
+    }
+    p = put_varint(p, zigzag(g->color[i] - color));
+    p = put_varint(p, zigzag(g->size[i] - size));
+    color = g->color[i];
+    size = g->size[i];
+  }
+  free(nb);
+  job->blocks[b] = buf;
+  job->sizes[b] = p - buf;
+}
+
+int write_graph_compressed(const Graph* g, const char* path, double max_error)
+{
+  ZipJob job = {.g = g};
+  ZipHeader* h = &job.h;
+  memset(h, 0, sizeof(ZipHeader));
+  memcpy(h->magic, ZIP_MAGIC, 8);
+  h->version = ZIP_VERSION;
+  h->n = g->n;
+  h->nb_blocks = (g->n + ZIP_BLOCK - 1) / ZIP_BLOCK;
+  for (int i = 0; i < g->n; i++)
+    h->nb_targets += g->degree[i];
+  if (max_error > 0.0) {
+    // Rounding to the nearest multiple of step: error <= step / 2
+    h->flags |= ZIP_LOSSY;
+    h->step = 2.0 * max_error;
+    h->minx = h->miny = INFINITY;
+    for (int i = 0; i < g->n; i++) {
+      h->minx = fmin(h->minx, g->x[i]);
+      h->miny = fmin(h->miny, g->y[i]);
+    }
+  }
+  int nb_blocks = (int)h->nb_blocks;
+  job.blocks = malloc(nb_blocks * sizeof(uint8_t*));
+  job.sizes = malloc(nb_blocks * sizeof(size_t));
+  parallel_for(nb_blocks, zip_block, &job);
+  ZipEntry* table = malloc((nb_blocks + 1) * sizeof(ZipEntry));
+  table[0].offset = 0;
+  table[0].first_target = 0;
+  for (int b = 0; b < nb_blocks; b++) {
+    table[b+1].offset = table[b].offset + job.sizes[b];
+    table[b+1].first_target = table[b].first_target;
+    for (int i = b * ZIP_BLOCK; i < g->n && i < (b + 1) * ZIP_BLOCK; i++)
+      table[b+1].first_target += g->degree[i];
+  }
+  h->table = BIN_HEADER_SIZE;
+  h->data = align_up(h->table + (nb_blocks + 1) * sizeof(ZipEntry));
+  h->file_size = h->data + table[nb_blocks].offset;
+  FILE* f = fopen(path, "wb");
+  bool ok = (f != NULL);
+  if (ok) {
+    ok = write_padded(f, h, sizeof(ZipHeader), BIN_HEADER_SIZE) &&
+         write_padded(f, table, (nb_blocks + 1) * sizeof(ZipEntry),
+                      (nb_blocks + 1) * sizeof(ZipEntry));
+    for (int b = 0; ok && b < nb_blocks; b++)
+      ok = fwrite(job.blocks[b], 1, job.sizes[b], f) == job.sizes[b];
+    ok = (fclose(f) == 0) && ok;
+  }
+  for (int b = 0; b < nb_blocks; b++)
+    free(job.blocks[b]);
+  free(job.blocks);
+  free(job.sizes);
+  free(table);
+  if (!ok) {
+    set_graph_error("cannot write %s", path);
+    return -1;
+  }
+  return 0;
+}
+
+static void unzip_block(void* ctx, int b)
+{
+  ZipJob* job = ctx;
+  Graph* g = job->out;
+  int i0 = b * ZIP_BLOCK, i1 = (i0 + ZIP_BLOCK < g->n ? i0 + ZIP_BLOCK : g->n);
+  const uint8_t* p = job->data + job->table[b].offset;
+  const uint8_t* end = job->data + job->table[b+1].offset;
+  int* t = job->targets + job->table[b].first_target;
+  const int* t_end = job->targets + job->table[b+1].first_target;
+  bool lossy = job->h.flags & ZIP_LOSSY;
+  int64_t qx = 0, qy = 0, color = 0, size = 0;
+  uint64_t v;
+  for (int i = i0; i < i1; i++) {
+    if ((p = get_varint(p, end, &v)) == NULL || v > (uint64_t)(t_end - t))
+      goto corrupt;
+    int d = (int)v;
+    g->degree[i] = d;
+    g->neighbors[i] = (d > 0 ? t : NULL);
+    int64_t prev = i;
+    for (int j = 0; j < d; j++) {
+      if ((p = get_varint(p, end, &v)) == NULL)
+        goto corrupt;
+      int64_t u = (j == 0 ? prev + unzigzag(v) : prev + (int64_t)v);
+      if (u < 0 || u >= g->n)
+        goto corrupt;
+      *t++ = (int)u;
+      prev = u;
+    }
+    if (lossy) {
+      uint64_t dx, dy;
+      if ((p = get_varint(p, end, &dx)) == NULL ||
+          (p = get_varint(p, end, &dy)) == NULL)
+        goto corrupt;
+      qx += unzigzag(dx);
+      qy += unzigzag(dy);
+      g->x[i] = job->h.minx + qx * job->h.step;
+      g->y[i] = job->h.miny + qy * job->h.step;
+    }
+    else {
+      if (end - p < (ptrdiff_t)(2 * sizeof(double)))
+        goto corrupt;
+      memcpy(&g->x[i], p, sizeof(double));
+      memcpy(&g->y[i], p + sizeof(double), sizeof(double));
+      p += 2 * sizeof(double);
+    }
+    uint64_t dc, ds;
+    if ((p = get_varint(p, end, &dc)) == NULL ||
+        (p = get_varint(p, end, &ds)) == NULL)
+      goto corrupt;
+    color += unzigzag(dc);
+    size += unzigzag(ds);
+    g->color[i] = (int)color;
+    g->size[i] = (int)size;
+  }
+  if (t == t_end && p == end)
+    return;
+corrupt:
+  job->failed[b] = true;
+}
+
+Graph read_graph_compressed(const char* path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    set_graph_error("cannot open %s", path);
+    return bad_graph();
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(ZipHeader)) {
+    set_graph_error("%s: not a compressed graph file", path);
+    close(fd);
+    return bad_graph();
+  }
+  size_t len = st.st_size;
+  uint8_t* base = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    set_graph_error("cannot map %s", path);
+    return bad_graph();
+  }
+  ZipJob job;
+  memcpy(&job.h, base, sizeof(ZipHeader));
+  ZipHeader* h = &job.h;
+  bool ok = memcmp(h->magic, ZIP_MAGIC, 8) == 0;
+  if (!ok)
+    set_graph_error("%s: not a compressed graph file", path);
+  else if (h->version != ZIP_VERSION) {
+    set_graph_error("%s: unsupported version %u", path, h->version);
+    ok = false;
+  }
+  else if (h->n < 0 || h->n > INT32_MAX || h->nb_targets < 0 ||
+           h->nb_blocks != (h->n + ZIP_BLOCK - 1) / ZIP_BLOCK ||
+           h->table < sizeof(ZipHeader) || h->data > len ||
+           h->table + (h->nb_blocks + 1) * sizeof(ZipEntry) > h->data ||
+           h->file_size != len) {
+    set_graph_error("%s: invalid or truncated compressed graph file", path);
+    ok = false;
+  }
+  job.table = (const ZipEntry*)(base + h->table);
+  job.data = base + h->data;
+  int nb_blocks = (ok ? (int)h->nb_blocks : 0);
+  // Block bounds must be increasing and inside the file
+  for (int b = 0; ok && b < nb_blocks; b++) {
+    if (job.table[b].offset > job.table[b+1].offset ||
+        job.table[b].first_target > job.table[b+1].first_target)
+      ok = false;
+  }
+  if (ok && (job.table[0].offset != 0 || job.table[0].first_target != 0 ||
+             job.table[nb_blocks].offset != len - h->data ||
+             job.table[nb_blocks].first_target != h->nb_targets)) {
+    ok = false;
+  }
+  if (!ok && memcmp(h->magic, ZIP_MAGIC, 8) == 0 && h->version == ZIP_VERSION)
+    set_graph_error("%s: invalid or truncated compressed graph file", path);
+  Graph g;
+  init_graph(&g);
+  if (ok) {
+    re_init_nodes(&g, (int)h->n, 0.0, NULL);
+    job.out = &g;
+    job.targets = arena_alloc(g.arena, h->nb_targets * sizeof(int));
+    job.failed = calloc(nb_blocks + 1, sizeof(bool));
+    parallel_for(nb_blocks, unzip_block, &job);
+    for (int b = 0; ok && b < nb_blocks; b++) {
+      if (job.failed[b]) {
+        set_graph_error("%s: corrupted block %d", path, b);
+        ok = false;
+      }
+    }
+    free(job.failed);
+  }
+  munmap(base, len);
+  if (!ok) {
+    free_graph(g);
+    return bad_graph();
+  }
+  return g;
+}
+
+/////////////////////////////
+// In-memory arrays
+/////////////////////////////
+
+// Nodes with positions pos (x0, y0, x1, y1...) or random
+static void array_nodes(Graph* g, int n, const double* pos, double width,
+                        int seed)
+{
+  Rng rng;
+  rng_init(&rng, seed);
+  re_init_nodes(g, n, width, (pos == NULL ? &rng : NULL));
+  if (pos != NULL) {
+    for (int i = 0; i < n; i++) {
+      g->x[i] = pos[2*i];
+      g->y[i] = pos[2*i + 1];
+    }
+  }
+}
+
+Graph graph_from_edges(int n, const int* edges, long m, const double* pos,
+                       double width, int seed)
+{
+  if (n < 0 || m < 0) {
+    set_graph_error("invalid sizes (n = %d, m = %ld)", n, m);
+    return bad_graph();
+  }
+  for (long k = 0; k < 2 * m; k++) {
+    if ((unsigned)edges[k] >= (unsigned)n) {
+      set_graph_error("edge %ld: node %d out of range", k / 2, edges[k]);
+      return bad_graph();
+    }
+  }
+  Graph g;
+  init_graph(&g);
+  array_nodes(&g, n, pos, width, seed);
+  build_adjacency(&g, edges, m);
+  return g;
+}
+
+Graph graph_from_csr(int n, const int64_t* offsets, int* targets,
+                     const double* pos, double width, int seed, bool copy)
+{
+  if (n < 0 || offsets[0] != 0) {
+    set_graph_error("invalid CSR offsets");
+    return bad_graph();
+  }
+  for (int i = 0; i < n; i++) {
+    int64_t d = offsets[i+1] - offsets[i];
+    if (d < 0 || d > INT_MAX) {
+      set_graph_error("invalid CSR offsets at row %d", i);
+      return bad_graph();
+    }
+  }
+  int64_t nb_targets = offsets[n];
+  for (int64_t k = 0; k < nb_targets; k++) {
+    if ((unsigned)targets[k] >= (unsigned)n) {
+      set_graph_error("CSR index %lld: node %d out of range", (long long)k,
+                      targets[k]);
+      return bad_graph();
+    }
+  }
+  Graph g;
+  init_graph(&g);
+  array_nodes(&g, n, pos, width, seed);
+  if (copy) {
+    int* own = arena_alloc(g.arena, nb_targets * sizeof(int));
+    if (nb_targets > 0)
+      memcpy(own, targets, nb_targets * sizeof(int));
+    targets = own;
+  }
+  for (int i = 0; i < n; i++) {
+    g.degree[i] = (int)(offsets[i+1] - offsets[i]);
+    g.neighbors[i] = (g.degree[i] > 0 ? targets + offsets[i] : NULL);
+  }
+  return g;
+}
@@ -0,0 +1,93 @@
+#ifndef GREM_GRAPH_IO_H
+#define GREM_GRAPH_IO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "graph.h"
+
+// Message describing the last failure of a function below (per thread)
+const char* graph_error(void);
+// Set this message (printf-like), for other modules reporting failures
+void set_graph_error(const char* fmt, ...);
+
+// Text format: "n m" line, n lines "x y color", m lines "u v"
+// (one record per line, blank lines ignored).
+// Positions are written with 6 decimals like printf("%f") (lossy).
+// Multithreaded; path "-" writes to stdout. Returns 0 on success, -1 on
+// error.
+int write_graph(Graph g, char* path);
+// Same with shortest decimal positions that read back exactly
+int write_graph_exact(Graph g, char* path);
+// Multithreaded parser. Path "-" reads stdin: pipes are parsed block by
+// block, in bounded memory besides the graph itself.
+// Malformed input is reported by graph_error() with its line number,
+// and the returned graph has n = -1 (free_graph() is still safe).
+Graph read_graph(char* path);
+
+// Importers. Nodes start at random positions in [0, width]^2 like
+// generated graphs; self-loops and multiple edges are dropped.
+// Edge list: one "u v" pair per line (further columns ignored), lines
+// starting with '#' or '%' are comments. Ids are any 64-bit integers,
+// numbered by order of first appearance: original ids are returned in
+// *ids (caller frees it) unless ids is NULL.
+Graph read_edge_list(char* path, double width, int seed, long long** ids);
+// Matrix Market coordinate file of a square matrix (values ignored)
+Graph read_matrix_market(char* path, double width, int seed);
+// METIS graph file (sizes and weights ignored)
+Graph read_metis(char* path, double width, int seed);
+
+// Binary format (version 1), little-endian, lossless:
+// 128-bytes header, then 64-bytes aligned sections
+//   x then y (float64, y = x + capacity), color, size, degree (int32),
+//   CSR offsets (int64, n + 1) and targets (int32, sum of degrees).
+// Returns 0 on success, -1 on error.
+int write_graph_binary(const Graph* g, const char* path);
+
+// Load a binary file into a regular graph. On error the returned graph
+// has n = -1 (free_graph() is still safe to call).
+Graph read_graph_binary(const char* path);
+
+// Zero-copy access: the graph arrays point into a private mapping of the
+// file (copy-on-write: the file is never modified), released by
+// free_graph(). Checked like read_graph_binary(), which reads all pages.
+Graph map_graph_binary(const char* path);
+
+// The same image in memory: size in bytes, then written to buf (len bytes
+// at least; returns 0 on success, -1 on error) and read back as a copy,
+// fully checked (on error n = -1).
+size_t graph_binary_size(const Graph* g);
+int write_graph_binary_buffer(const Graph* g, void* buf, size_t len);
+Graph read_graph_binary_buffer(const void* buf, size_t len);
+
+// POSIX shared memory object name ("/grem-..."), holding the binary image.
+// share_graph() creates it (fails if it exists, returns 0 or -1);
+// attach_graph() maps it like map_graph_binary() (private copy-on-write,
+// other processes see no change), with the same full check as
+// read_graph_binary_buffer(). The object lives until
+// unlink_shared_graph(), even once all graphs attached are freed.
+int share_graph(const Graph* g, const char* name);
+Graph attach_graph(const char* name);
+int unlink_shared_graph(const char* name);
+
+// Compressed format: neighbors lists sorted and delta-encoded as varints,
+// positions quantized with error <= max_error (stored exactly if
+// max_error <= 0), by blocks of nodes encoded and decoded in parallel.
+// Neighbors come back sorted. Returns 0 on success, -1 on error.
+int write_graph_compressed(const Graph* g, const char* path, double max_error);
+// On error the returned graph has n = -1
+Graph read_graph_compressed(const char* path);
+
+// In-memory arrays. Nodes take positions pos (x0, y0, x1, y1...) or
+// random ones in [0, width]^2 if pos is NULL. On error (index out of
+// range...) the returned graph has n = -1.
+// Undirected edges {edges[2k], edges[2k+1]}, kept as given (loops and
+// multiple edges included), copied.
+Graph graph_from_edges(int n, const int* edges, long m, const double* pos,
+                       double width, int seed);
+// CSR: neighbors of i are targets[offsets[i]..offsets[i+1]) (each edge
+// listed at both ends). Unless copy, the graph uses targets in place:
+// they must outlive it, and reordering the graph rewrites them.
+Graph graph_from_csr(int n, const int64_t* offsets, int* targets,
+                     const double* pos, double width, int seed, bool copy);
+
+#endif
@@ -0,0 +1,424 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "graph_models.h"
+#include "parallel.h"
+
+// Target number of edges sampled by one task
+#define EDGES_PER_TASK (1 << 16)
+
+/////////////////////////////
+// Stochastic block model
+/////////////////////////////
+
+// Rows [r0, r1) of the pairs between two groups starting at nodes a0, b0:
+// inside one group (a0 == b0), row v holds pairs (v, w < v);
+// otherwise row i holds the nb pairs (i, j) of the second group.
+typedef struct PairRange {
+  int a0, b0, nb;
+  long r0, r1;
+  double p;
+  Rng rng;
+  int* edges;
+  long m;
+} PairRange;
+
+static double range_pairs(const PairRange* pr, long r0, long r1)
+{
+  if (pr->a0 == pr->b0)
+    return 0.5 * ((double)r1 * (r1 - 1) - (double)r0 * (r0 - 1));
+  return (double)(r1 - r0) * pr->nb;
+}
+
+// Geometric skips from one edge to the next (Batagelj-Brandes)
+static void sample_range(void* ctx, int t)
+{
+  PairRange* pr = &((PairRange*)ctx)[t];
+  bool inside = (pr->a0 == pr->b0);
+  double pairs = range_pairs(pr, pr->r0, pr->r1);
+  long capacity = (long)(pr->p * pairs) + 16;
+  pr->edges = malloc(2 * capacity * sizeof(int));
+  pr->m = 0;
+  double lq = log(1.0 - pr->p);
+  long r = pr->r0, c = -1;
+  while (r < pr->r1) {
+    double skip = floor(log(1.0 - rng_uniform(&pr->rng)) / lq);
+    if (skip >= pairs)
+      break;
+    c += 1 + (long)skip;
+    while (r < pr->r1 && c >= (inside ? r : pr->nb)) {
+      c -= (inside ? r : pr->nb);
+      r++;
+    }
+    if (r < pr->r1) {
+      if (pr->m == capacity) {
+        capacity *= 2;
+        pr->edges = realloc(pr->edges, 2 * capacity * sizeof(int));
+      }
+      pr->edges[2*pr->m] = pr->a0 + (int)r;
+      pr->edges[2*pr->m+1] = pr->b0 + (int)c;
+      pr->m++;
+    }
+  }
+}
+
+Graph make_random_sbm_graph(int nb_blocks, const int* sizes,
+                            const double* probs, double width, int seed)
+{
+  Rng rng;
+  rng_init(&rng, seed);
+  int n = 0;
+  int* first = malloc((nb_blocks + 1) * sizeof(int));
+  for (int a = 0; a < nb_blocks; a++) {
+    first[a] = n;
+    n += sizes[a];
+  }
+  Graph g;
+  init_graph(&g);
+  re_init_nodes(&g, n, width, &rng);
+  // Cut each block pair in ranges of rows with ~EDGES_PER_TASK edges.
+  // Tasks only depend on parameters: each gets the next split stream.
+  int nb_tasks = 0, capacity = 16;
+  PairRange* tasks = malloc(capacity * sizeof(PairRange));
+  for (int a = 0; a < nb_blocks; a++) {
+    for (int b = a; b < nb_blocks; b++) {
+      double p = probs[a * nb_blocks + b];
+      if (p <= 0.0 || sizes[a] == 0 || sizes[b] == 0)
+        continue;
+      PairRange pr = {.a0 = first[a], .b0 = first[b], .nb = sizes[b],
+                      .p = fmin(p, 1.0)};
+      long rows = sizes[a];
+      double total = range_pairs(&pr, 0, rows);
+      int nb_chunks = (int)fmin(ceil(total * pr.p / EDGES_PER_TASK), rows);
+      if (nb_chunks < 1)
+        nb_chunks = 1;
+      long r = (a == b ? 1 : 0); //row 0 is empty inside a group
+      for (int k = 0; k < nb_chunks; k++) {
+        pr.r0 = r;
+        double target = total * (k + 1) / nb_chunks;
+        while (r < rows && range_pairs(&pr, 0, r) < target)
+          r++;
+        pr.r1 = (k == nb_chunks - 1 ? rows : r);
+        pr.rng = rng_split(&rng);
+        if (nb_tasks == capacity) {
+          capacity *= 2;
+          tasks = realloc(tasks, capacity * sizeof(PairRange));
+        }
+        tasks[nb_tasks++] = pr;
+      }
+    }
+  }
+  parallel_for(nb_tasks, sample_range, tasks);
+  int** parts = malloc(nb_tasks * sizeof(int*));
+  long* counts = malloc(nb_tasks * sizeof(long));
+  for (int t = 0; t < nb_tasks; t++) {
+    parts[t] = tasks[t].edges;
+    counts[t] = tasks[t].m;
+  }
+  build_adjacency_parts(&g, parts, counts, nb_tasks);
+  for (int t = 0; t < nb_tasks; t++)
+    free(tasks[t].edges);
+  free(counts);
+  free(parts);
+  free(tasks);
+  free(first);
+  return g;
+}
+
+/////////////////////////////
+// Chung-Lu
+/////////////////////////////
+
+// Walker's alias table: O(1) sampling of i with probability w[i] / sum(w).
+// Both fields of a cell are read together: one cache miss per sample.
+typedef struct AliasCell {
+  double prob;
+  int alias;
+} AliasCell;
+
+static AliasCell* new_alias_table(int n, const double* w, double sum)
+{
+  AliasCell* at = malloc(n * sizeof(AliasCell));
+  int* small = malloc(n * sizeof(int));
+  int* large = malloc(n * sizeof(int));
+  int ns = 0, nl = 0;
+  for (int i = 0; i < n; i++) {
+    at[i].prob = (w[i] > 0.0 ? w[i] * n / sum : 0.0);
+    at[i].alias = i;
+    if (at[i].prob < 1.0)
+      small[ns++] = i;
+    else
+      large[nl++] = i;
+  }
+  while (ns > 0 && nl > 0) {
+    int s = small[--ns], l = large[nl-1];
+    at[s].alias = l;
+    at[l].prob -= 1.0 - at[s].prob;
+    if (at[l].prob < 1.0) {
+      nl--;
+      small[ns++] = l;
+    }
+  }
+  // Leftovers are 1 up to rounding errors
+  while (nl > 0)
+    at[large[--nl]].prob = 1.0;
+  while (ns > 0)
+    at[small[--ns]].prob = 1.0;
+  free(large);
+  free(small);
+  return at;
+}
+
+static inline int alias_sample(const AliasCell* at, int n, Rng* rng)
+{
+  int i = rng_below(rng, n);
+  return (rng_uniform(rng) < at[i].prob ? i : at[i].alias);
+}
+
+typedef struct EdgeChunk {
+  long m; //edges to draw
+  Rng rng;
+  int* edges;
+  long kept; //after self-loops removal
+} EdgeChunk;
+
+typedef struct ChungLuJob {
+  int n;
+  const AliasCell* at;
+  EdgeChunk* chunks;
+} ChungLuJob;
+
+static void sample_chunk(void* ctx, int t)
+{
+  ChungLuJob* job = ctx;
+  EdgeChunk* ch = &job->chunks[t];
+  ch->edges = malloc(2 * ch->m * sizeof(int));
+  ch->kept = 0;
+  for (long k = 0; k < ch->m; k++) {
+    int u = alias_sample(job->at, job->n, &ch->rng),
+        v = alias_sample(job->at, job->n, &ch->rng);
+    if (u != v) {
+      ch->edges[2*ch->kept] = u;
+      ch->edges[2*ch->kept+1] = v;
+      ch->kept++;
+    }
+  }
+}
+
+Graph make_random_chung_lu_graph(int n, const double* weights, double width,
+                                 int seed)
+{
+  Rng rng;
+  rng_init(&rng, seed);
+  Graph g;
+  init_graph(&g);
+  re_init_nodes(&g, n, width, &rng);
+  double sum = 0.0;
+  for (int i = 0; i < n; i++)
+    sum += fmax(weights[i], 0.0);
+  if (n <= 1 || sum <= 0.0)
+    return g;
+  AliasCell* at = new_alias_table(n, weights, sum);
+  long m = lround(sum / 2);
+  int nb_chunks = (int)((m + EDGES_PER_TASK - 1) / EDGES_PER_TASK);
+  EdgeChunk* chunks = malloc(nb_chunks * sizeof(EdgeChunk));
+  for (int t = 0; t < nb_chunks; t++) {
+    chunks[t].m = (t < nb_chunks - 1 ? EDGES_PER_TASK
+                                     : m - (long)t * EDGES_PER_TASK);
+    chunks[t].rng = rng_split(&rng);
+  }
+  ChungLuJob job = {.n = n, .at = at, .chunks = chunks};
+  parallel_for(nb_chunks, sample_chunk, &job);
+  int** parts = malloc(nb_chunks * sizeof(int*));
+  long* counts = malloc(nb_chunks * sizeof(long));
+  for (int t = 0; t < nb_chunks; t++) {
+    parts[t] = chunks[t].edges;
+    counts[t] = chunks[t].kept;
+  }
+  build_adjacency_parts(&g, parts, counts, nb_chunks);
+  simplify_graph(&g);
+  for (int t = 0; t < nb_chunks; t++)
+    free(chunks[t].edges);
+  free(counts);
+  free(parts);
+  free(chunks);
+  free(at);
+  return g;
+}
+
+/////////////////////////////
+// Random geometric graph
+/////////////////////////////
+
+// Points are bucketed in a grid of nc x nc cells of side >= r: neighbors
+// of a point lie in its cell or in the 8 around it. Each cell is compared
+// with itself and 4 "forward" cells, so every pair is seen once.
+// Tasks cover ranges of grid rows.
+#define RGG_TASKS 256
+
+typedef struct RggJob {
+  const Graph* g;
+  int nc;
+  double r2;
+  const int* cell_start; //nc*nc + 1 offsets into sorted
+  const int* sorted; //nodes ordered by cell
+  int* rows; //RGG_TASKS + 1 grid row bounds
+  int** edges;
+  long* counts;
+} RggJob;
+
+static void rgg_task(void* ctx, int t)
+{
+  RggJob* job = ctx;
+  const Graph* g = job->g;
+  int nc = job->nc;
+  long m = 0, capacity = 1024;
+  int* edges = malloc(2 * capacity * sizeof(int));
+  static const int forward[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+  for (int cy = job->rows[t]; cy < job->rows[t+1]; cy++) {
+    for (int cx = 0; cx < nc; cx++) {
+      int c = cy * nc + cx;
+      for (int k = -1; k < 4; k++) {
+        int ox = cx, oy = cy;
+        if (k >= 0) {
+          ox += forward[k][0];
+          oy += forward[k][1];
+          if (ox < 0 || ox >= nc || oy >= nc)
+            continue;
+        }
+        int o = oy * nc + ox;
+        for (int a = job->cell_start[c]; a < job->cell_start[c+1]; a++) {
+          int u = job->sorted[a];
+          // Same cell: only pairs (a, b > a)
+          int b0 = (k < 0 ? a + 1 : job->cell_start[o]);
+          for (int b = b0; b < job->cell_start[o+1]; b++) {
+            int v = job->sorted[b];
+            double ddx = g->x[u] - g->x[v], ddy = g->y[u] - g->y[v];
+            if (ddx * ddx + ddy * ddy > job->r2)
+              continue;
+            if (m == capacity) {
+              capacity *= 2;
+              edges = realloc(edges, 2 * capacity * sizeof(int));
+            }
+            edges[2*m] = u;
+            edges[2*m+1] = v;
+            m++;
+          }
+        }
+      }
+    }
+  }
+  job->edges[t] = edges;
+  job->counts[t] = m;
+}
+
+Graph make_random_geometric_graph(int n, double r, double width, int seed)
+{
+  Rng rng;
+  rng_init(&rng, seed);
+  Graph g;
+  init_graph(&g);
+  re_init_nodes(&g, n, width, &rng);
+  if (n <= 1 || r <= 0.0 || width <= 0.0)
+    return g;
+  // Cells of side >= r, but not (much) more cells than points
+  int nc = (int)fmin(width / r, sqrt(2.0 * n));
+  if (nc < 1)
+    nc = 1;
+  int nb_cells = nc * nc;
+  int* cell = malloc(n * sizeof(int));
+  int* cell_start = calloc(nb_cells + 1, sizeof(int));
+  for (int i = 0; i < n; i++) {
+    int cx = (int)(g.x[i] * nc / width), cy = (int)(g.y[i] * nc / width);
+    cx = (cx < nc ? cx : nc - 1);
+    cy = (cy < nc ? cy : nc - 1);
+    cell[i] = cy * nc + cx;
+    cell_start[cell[i] + 1]++;
+  }
+  for (int c = 0; c < nb_cells; c++)
+    cell_start[c+1] += cell_start[c];
+  int* sorted = malloc(n * sizeof(int));
+  int* fill = malloc(nb_cells * sizeof(int));
+  memcpy(fill, cell_start, nb_cells * sizeof(int));
+  for (int i = 0; i < n; i++)
+    sorted[fill[cell[i]]++] = i;
+  free(fill);
+  free(cell);
+  int nb_tasks = (nc < RGG_TASKS ? nc : RGG_TASKS);
+  int* rows = malloc((nb_tasks + 1) * sizeof(int));
+  for (int t = 0; t <= nb_tasks; t++)
+    rows[t] = (int)((long)nc * t / nb_tasks);
+  RggJob job = {.g = &g, .nc = nc, .r2 = r * r, .cell_start = cell_start,
+                .sorted = sorted, .rows = rows,
+                .edges = malloc(nb_tasks * sizeof(int*)),
+                .counts = malloc(nb_tasks * sizeof(long))};
+  parallel_for(nb_tasks, rgg_task, &job);
+  build_adjacency_parts(&g, job.edges, job.counts, nb_tasks);
+  for (int t = 0; t < nb_tasks; t++)
+    free(job.edges[t]);
+  free(job.counts);
+  free(job.edges);
+  free(rows);
+  free(sorted);
+  free(cell_start);
+  return g;
+}
+
+/////////////////////////////
+// Lattices
+/////////////////////////////
+
+// Node (i, j) of a rows x cols lattice has index i * cols + j.
+// Edges to the right and below, then optional diagonal and wrap-around.
+static Graph make_lattice(int rows, int cols, bool diagonal, bool wrap,
+                          double width, int seed)
+{
+  Rng rng;
+  rng_init(&rng, seed);
+  Graph g;
+  init_graph(&g);
+  int n = rows * cols;
+  re_init_nodes(&g, n, width, &rng);
+  // Wrapping 1 or 2 nodes wide would duplicate edges
+  bool wrap_row = wrap && cols > 2, wrap_col = wrap && rows > 2;
+  int* edges = malloc(6 * (long)n * sizeof(int));
+  long m = 0;
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      int u = i * cols + j;
+      if (j + 1 < cols || wrap_row) {
+        edges[2*m] = u;
+        edges[2*m+1] = i * cols + (j + 1) % cols;
+        m++;
+      }
+      if (i + 1 < rows || wrap_col) {
+        edges[2*m] = u;
+        edges[2*m+1] = ((i + 1) % rows) * cols + j;
+        m++;
+      }
+      if (diagonal && i + 1 < rows && j + 1 < cols) {
+        edges[2*m] = u;
+        edges[2*m+1] = u + cols + 1;
+        m++;
+      }
+    }
+  }
+  build_adjacency(&g, edges, m);
+  free(edges);
+  return g;
+}
+
+Graph make_grid_graph(int rows, int cols, double width, int seed)
+{
+  return make_lattice(rows, cols, false, false, width, seed);
+}
+
+Graph make_triangular_mesh(int rows, int cols, double width, int seed)
+{
+  return make_lattice(rows, cols, true, false, width, seed);
+}
+
+Graph make_torus_graph(int rows, int cols, double width, int seed)
+{
+  return make_lattice(rows, cols, false, true, width, seed);
+}
@@ -0,0 +1,33 @@
+#ifndef GREM_GRAPH_MODELS_H
+#define GREM_GRAPH_MODELS_H
+
+#include "graph.h"
+
+// Stochastic block model: nb_blocks groups of sizes[a] consecutive nodes,
+// edge {u,v} with probability probs[a*nb_blocks + b] (symmetric matrix)
+// for u in group a, v in group b. O(n + m), multithreaded, same output
+// for any number of threads.
+Graph make_random_sbm_graph(int nb_blocks, const int* sizes,
+                            const double* probs, double width, int seed);
+
+// Chung-Lu graph: about sum(weights)/2 edges with endpoints drawn
+// proportionally to weights (expected degrees), self-loops and multiple
+// edges removed. O(n + m), multithreaded, same output for any number
+// of threads.
+Graph make_random_chung_lu_graph(int n, const double* weights, double width,
+                                 int seed);
+
+// Random geometric graph: n points at random in [0, width]^2, connected
+// when at distance <= r. O(n + m) with a grid of cells, multithreaded.
+Graph make_random_geometric_graph(int n, double r, double width, int seed);
+
+// Lattices with rows x cols nodes, node (i, j) at index i * cols + j.
+// Nodes start at random positions like other generators: the lattice
+// itself is the expected layout.
+Graph make_grid_graph(int rows, int cols, double width, int seed);
+// Grid plus one diagonal per square: all inner faces are triangles
+Graph make_triangular_mesh(int rows, int cols, double width, int seed);
+// Grid with wrap-around edges on both axes
+Graph make_torus_graph(int rows, int cols, double width, int seed);
+
+#endif
@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "graph_order.h"
+
+#define HILBERT_BITS 16
+
+static int cmp_u64(const void* a, const void* b)
+{
+  uint64_t u = *(const uint64_t*)a, v = *(const uint64_t*)b;
+  return (u > v) - (u < v);
+}
+
+// Breadth-first numbering of all components. With by_degree, neighbors
+// are visited by increasing degree and each component starts from a node
+// of minimum degree (Cuthill-McKee).
+static void bfs_order(const Graph* g, int* perm, bool by_degree)
+{
+  bool* seen = calloc(g->n, sizeof(bool));
+  uint64_t* keys = NULL;
+  int* starts = malloc(g->n * sizeof(int));
+  for (int i = 0; i < g->n; i++)
+    starts[i] = i;
+  if (by_degree) {
+    keys = malloc(g->n * sizeof(uint64_t));
+    for (int i = 0; i < g->n; i++)
+      keys[i] = ((uint64_t)g->degree[i] << 32) | (uint32_t)i;
+    qsort(keys, g->n, sizeof(uint64_t), cmp_u64);
+    for (int i = 0; i < g->n; i++)
+      starts[i] = (int)(keys[i] & 0xffffffff);
+  }
+  int back = 0;
+  for (int s = 0; s < g->n; s++) {
+    if (seen[starts[s]])
+      continue;
+    int front = back;
+    perm[back++] = starts[s];
+    seen[starts[s]] = true;
+    while (front < back) {
+      int u = perm[front++];
+      int first = back;
+      for (int j = 0; j < g->degree[u]; j++) {
+        int v = g->neighbors[u][j];
+        if (!seen[v]) {
+          seen[v] = true;
+          perm[back++] = v;
+        }
+      }
+      if (by_degree && back - first > 1) {
+        int cnt = back - first;
+        for (int j = 0; j < cnt; j++) {
+          int v = perm[first + j];
+          keys[j] = ((uint64_t)g->degree[v] << 32) | (uint32_t)v;
+        }
+        qsort(keys, cnt, sizeof(uint64_t), cmp_u64);
+        for (int j = 0; j < cnt; j++)
+          perm[first + j] = (int)(keys[j] & 0xffffffff);
+      }
+    }
+  }
+  free(keys);
+  free(starts);
+  free(seen);
+}
+
+// Index of (x, y) along the Hilbert curve filling a 2^bits square
+static uint64_t hilbert_index(uint32_t x, uint32_t y, int bits)
+{
+  uint64_t d = 0;
+  for (uint32_t s = 1u << (bits - 1); s > 0; s >>= 1) {
+    uint32_t rx = (x & s) ? 1 : 0,
+             ry = (y & s) ? 1 : 0;
+    d += (uint64_t)s * s * ((3 * rx) ^ ry);
+    // Rotate the quadrant
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - (x & (s - 1));
+        y = s - 1 - (y & (s - 1));
+      }
+      uint32_t t = x;
+      x = y;
+      y = t;
+    }
+    x &= s - 1;
+    y &= s - 1;
+  }
+  return d;
+}
+
+static void hilbert_order(const Graph* g, int* perm)
+{
+  double minx = +INFINITY, maxx = -INFINITY,
+         miny = +INFINITY, maxy = -INFINITY;
+  for (int i = 0; i < g->n; i++) {
+    minx = fmin(minx, g->x[i]);
+    maxx = fmax(maxx, g->x[i]);
+    miny = fmin(miny, g->y[i]);
+    maxy = fmax(maxy, g->y[i]);
+  }
+  double side = fmax(maxx - minx, maxy - miny);
+  double scale = (side > 0.0 ? ((1 << HILBERT_BITS) - 1) / side : 0.0);
+  uint64_t* keys = malloc(g->n * sizeof(uint64_t));
+  for (int i = 0; i < g->n; i++) {
+    uint32_t hx = (uint32_t)((g->x[i] - minx) * scale),
+             hy = (uint32_t)((g->y[i] - miny) * scale);
+    // 2*HILBERT_BITS bits of curve index, then the node
+    keys[i] = (hilbert_index(hx, hy, HILBERT_BITS) << 32) | (uint32_t)i;
+  }
+  qsort(keys, g->n, sizeof(uint64_t), cmp_u64);
+  for (int i = 0; i < g->n; i++)
+    perm[i] = (int)(keys[i] & 0xffffffff);
+  free(keys);
+}
+
+int* graph_order(const Graph* g, int mode)
+{
+  int* perm = malloc(g->n * sizeof(int));
+  if (mode == ORDER_HILBERT)
+    hilbert_order(g, perm);
+  else {
+    bfs_order(g, perm, mode == ORDER_RCM);
+    if (mode == ORDER_RCM) {
+      for (int i = 0, j = g->n - 1; i < j; i++, j--) {
+        int tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+      }
+    }
+  }
+  return perm;
+}
+
+static void permute_doubles(double* v, const int* perm, int n, double* tmp)
+{
+  for (int i = 0; i < n; i++)
+    tmp[i] = v[perm[i]];
+  memcpy(v, tmp, n * sizeof(double));
+}
+
+static void permute_ints(int* v, const int* perm, int n, int* tmp)
+{
+  for (int i = 0; i < n; i++)
+    tmp[i] = v[perm[i]];
+  memcpy(v, tmp, n * sizeof(int));
+}
+
+void permute_graph(Graph* g, const int* perm)
+{
+  int n = g->n;
+  double* tmp = malloc(n * sizeof(double)); //also fits n ints
+  permute_doubles(g->x, perm, n, tmp);
+  permute_doubles(g->y, perm, n, tmp);
+  permute_doubles(g->dx, perm, n, tmp);
+  permute_doubles(g->dy, perm, n, tmp);
+  permute_ints(g->degree, perm, n, (int*)tmp);
+  permute_ints(g->size, perm, n, (int*)tmp);
+  permute_ints(g->color, perm, n, (int*)tmp);
+  int** lists = malloc(n * sizeof(int*));
+  for (int i = 0; i < n; i++)
+    lists[i] = g->neighbors[perm[i]];
+  memcpy(g->neighbors, lists, n * sizeof(int*));
+  free(lists);
+  // Relabel neighbors: old index -> new index
+  int* inv = (int*)tmp;
+  for (int i = 0; i < n; i++)
+    inv[perm[i]] = i;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < g->degree[i]; j++)
+      g->neighbors[i][j] = inv[g->neighbors[i][j]];
+  }
+  free(tmp);
+}
+
+int* reorder_graph(Graph* g, int mode)
+{
+  int* perm = graph_order(g, mode);
+  permute_graph(g, perm);
+  return perm;
+}
@@ -0,0 +1,21 @@
+#ifndef GREM_GRAPH_ORDER_H
+#define GREM_GRAPH_ORDER_H
+
+#include "graph.h"
+
+// Node orderings: reverse Cuthill-McKee, breadth-first, Hilbert curve
+// on current positions.
+enum {ORDER_RCM=0, ORDER_BFS, ORDER_HILBERT};
+
+// Permutation perm[new] = old for the given ordering (caller frees it)
+int* graph_order(const Graph* g, int mode);
+
+// Move node perm[i] to index i, relabelling neighbors accordingly.
+// Buffers are rewritten in place: pointers into the graph stay valid.
+void permute_graph(Graph* g, const int* perm);
+
+// Renumber nodes for memory locality. Returns the applied permutation
+// perm[new] = old (caller frees it), e.g. to map back ids or colors.
+int* reorder_graph(Graph* g, int mode);
+
+#endif
@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "parallel.h"
+
+static atomic_int num_threads = 0; //set while other threads may run
+
+void set_num_threads(int k)
+{
+  num_threads = (k > 0 ? k : 0);
+}
+
+int get_num_threads(void)
+{
+  if (num_threads > 0)
+    return num_threads;
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return (cores > 0 ? (int)cores : 1);
+}
+
+typedef struct Job {
+  void (*task)(void*, int);
+  void* ctx;
+  int nb_tasks;
+  atomic_int next;
+} Job;
+
+static void* run_tasks(void* arg)
+{
+  Job* job = arg;
+  int t;
+  while ((t = atomic_fetch_add(&job->next, 1)) < job->nb_tasks)
+    job->task(job->ctx, t);
+  return NULL;
+}
+
+void parallel_for(int nb_tasks, void (*task)(void* ctx, int t), void* ctx)
+{
+  int nt = get_num_threads();
+  if (nt > nb_tasks)
+    nt = nb_tasks;
+  if (nt <= 1) {
+    for (int t = 0; t < nb_tasks; t++)
+      task(ctx, t);
+    return;
+  }
+  Job job = {.task = task, .ctx = ctx, .nb_tasks = nb_tasks};
+  atomic_init(&job.next, 0);
+  pthread_t* threads = malloc((nt - 1) * sizeof(pthread_t));
+  int started = 0;
+  for (; started < nt - 1; started++) {
+    if (pthread_create(&threads[started], NULL, run_tasks, &job) != 0)
+      break; //remaining work done by the others
+  }
+  run_tasks(&job);
+  for (int i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+  free(threads);
+}
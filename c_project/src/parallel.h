@@ -0,0 +1,14 @@
+#ifndef GREM_PARALLEL_H
+#define GREM_PARALLEL_H
+
+// Number of worker threads used by parallel routines
+// (k <= 0: one per available core, the default).
+void set_num_threads(int k);
+int get_num_threads(void);
+
+// Run task(ctx, t) for t in [0, nb_tasks) on the worker threads.
+// Tasks are picked dynamically: results must not depend on which thread
+// runs them (e.g. per-task random streams and output buffers).
+void parallel_for(int nb_tasks, void (*task)(void* ctx, int t), void* ctx);
+
+#endif
@@ -0,0 +1,87 @@
+#include <time.h>
+#include "rng.h"
+
+static uint64_t splitmix64(uint64_t* x)
+{
+  uint64_t z = (*x += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+void rng_init(Rng* r, int seed)
+{
+  uint64_t x = (seed >= 0 ? (uint64_t)seed : (uint64_t)time(NULL));
+  for (int i = 0; i < 4; i++)
+    r->s[i] = splitmix64(&x);
+}
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+uint64_t rng_next(Rng* r)
+{
+  uint64_t* s = r->s;
+  uint64_t result = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return result;
+}
+
+double rng_uniform(Rng* r)
+{
+  return (rng_next(r) >> 11) * 0x1.0p-53;
+}
+
+// Lemire's multiply-shift, with rejection of the biased low range
+uint64_t rng_below(Rng* r, uint64_t bound)
+{
+  __uint128_t m = (__uint128_t)rng_next(r) * bound;
+  uint64_t low = (uint64_t)m;
+  if (low < bound) {
+    uint64_t threshold = -bound % bound;
+    while (low < threshold) {
+      m = (__uint128_t)rng_next(r) * bound;
+      low = (uint64_t)m;
+    }
+  }
+  return (uint64_t)(m >> 64);
+}
+
+void rng_jump(Rng* r)
+{
+  static const uint64_t JUMP[] = {
+    0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+    0xa9582618e03fc9aa, 0x39abdc4529b1661c
+  };
+  uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (int i = 0; i < 4; i++) {
+    for (int b = 0; b < 64; b++) {
+      if (JUMP[i] & ((uint64_t)1 << b)) {
+        s0 ^= r->s[0];
+        s1 ^= r->s[1];
+        s2 ^= r->s[2];
+        s3 ^= r->s[3];
+      }
+      rng_next(r);
+    }
+  }
+  r->s[0] = s0;
+  r->s[1] = s1;
+  r->s[2] = s2;
+  r->s[3] = s3;
+}
+
+Rng rng_split(Rng* r)
+{
+  Rng child = *r;
+  rng_jump(r);
+  return child;
+}
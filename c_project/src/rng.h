@@ -0,0 +1,30 @@
+#ifndef GREM_RNG_H
+#define GREM_RNG_H
+
+#include <stdint.h>
+
+// xoshiro256** generator (https://prng.di.unimi.it/): one independent,
+// reproducible stream per generator or worker thread (no global state).
+typedef struct Rng {
+  uint64_t s[4];
+} Rng;
+
+// Seed from an integer (time-based if seed < 0)
+void rng_init(Rng* r, int seed);
+
+uint64_t rng_next(Rng* r);
+
+// Uniform double in [0, 1)
+double rng_uniform(Rng* r);
+
+// Uniform integer in [0, bound), without modulo bias
+uint64_t rng_below(Rng* r, uint64_t bound);
+
+// Advance by 2^128 steps
+void rng_jump(Rng* r);
+
+// New stream starting at the current state of r, which jumps ahead:
+// successive splits give non-overlapping sequences.
+Rng rng_split(Rng* r);
+
+#endif
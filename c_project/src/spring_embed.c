@@ -1,7 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <limits.h>
 #include <math.h>
+#include <unistd.h>
 #include "graph_dist.h"
+#include "graph_io.h"
+#include "graph_order.h"
 #include "spring_embed.h"
 
 #define COOLING 0.95
@@ -17,23 +24,26 @@
 #define DEFAULT_NODE_EDGE_CUTOFF_FACTOR 0.55
 #define DEFAULT_NODE_EDGE_REPULSION 0.15
 
-QuadTree* new_quadtree(double cx, double cy, double width)
+#define LAYOUT_MAGIC "GREMLAY" //with final '\0': 8 bytes
+#define LAYOUT_VERSION 1
+
+QuadTree* new_quadtree(Arena* a, double cx, double cy, double width)
 {
-  QuadTree* qt = malloc(sizeof(QuadTree));
+  QuadTree* qt = arena_alloc(a, sizeof(QuadTree));
   qt->cx = cx;
   qt->cy = cy;
   for (int dir=0; dir<4; dir++)
     qt->subtree[dir] = NULL;
   qt->size = width;
   qt->mass = 0;
-  qt->node = NULL;
+  qt->node = -1;
   return qt;
 }
 
-static int pick_dir(const QuadTree* qt, const Node* p)
+static int pick_dir(const QuadTree* qt, double x, double y)
 {
-  int east = (p->x >= qt->cx) ? 1 : 0;
-  int north = (p->y >= qt->cy) ? 1 : 0;
+  int east = (x >= qt->cx) ? 1 : 0;
+  int north = (y >= qt->cy) ? 1 : 0;
   return east + 2 * north;
 }
 
@@ -47,94 +57,86 @@ static void child_center(const QuadTree* qt, int dir, double* ccx, double* ccy)
 }
 
 // Robust insertion (supports very close or identical positions)
-void insert_quadtree(QuadTree* qt, Node* p)
+void insert_quadtree(Arena* a, QuadTree* qt, const Graph* g, int p)
 {
+  double px = g->x[p], py = g->y[p];
   if (qt->size < QUAD_MIN_SIZE) {
     // Stop splitting tiny cells; keep only aggregated mass/center.
     if (qt->mass == 0) {
       qt->node = p;
-      qt->mx = p->x;
-      qt->my = p->y;
+      qt->mx = px;
+      qt->my = py;
       qt->mass = 1;
       return;
     }
-    qt->mx = (qt->mx * qt->mass + p->x) / (qt->mass + 1.0);
-    qt->my = (qt->my * qt->mass + p->y) / (qt->mass + 1.0);
+    qt->mx = (qt->mx * qt->mass + px) / (qt->mass + 1.0);
+    qt->my = (qt->my * qt->mass + py) / (qt->mass + 1.0);
     qt->mass++;
-    qt->node = NULL;
+    qt->node = -1;
     return;
   }
 
   if (qt->mass == 0) {
     qt->node = p;
-    qt->mx = p->x;
-    qt->my = p->y;
+    qt->mx = px;
+    qt->my = py;
     qt->mass = 1;
     return;
   }
 
   // Mettre à jour le centre de masse
-  qt->mx = (qt->mx * qt->mass + p->x) / (qt->mass + 1.0);
-  qt->my = (qt->my * qt->mass + p->y) / (qt->mass + 1.0);
+  qt->mx = (qt->mx * qt->mass + px) / (qt->mass + 1.0);
+  qt->my = (qt->my * qt->mass + py) / (qt->mass + 1.0);
   qt->mass++;
 
   double hs = qt->size / 2.0;
 
-  if (qt->node != NULL) {
-    Node* old = qt->node;
-    qt->node = NULL;
-    int dir_old = pick_dir(qt, old);
+  if (qt->node >= 0) {
+    int old = qt->node;
+    qt->node = -1;
+    int dir_old = pick_dir(qt, g->x[old], g->y[old]);
     double ccx, ccy;
     child_center(qt, dir_old, &ccx, &ccy);
     if (qt->subtree[dir_old] == NULL)
-      qt->subtree[dir_old] = new_quadtree(ccx, ccy, hs);
-    insert_quadtree(qt->subtree[dir_old], old);
+      qt->subtree[dir_old] = new_quadtree(a, ccx, ccy, hs);
+    insert_quadtree(a, qt->subtree[dir_old], g, old);
   }
 
-  int dir_new = pick_dir(qt, p);
+  int dir_new = pick_dir(qt, px, py);
   double ccx, ccy;
   child_center(qt, dir_new, &ccx, &ccy);
   if (qt->subtree[dir_new] == NULL)
-    qt->subtree[dir_new] = new_quadtree(ccx, ccy, hs);
-  insert_quadtree(qt->subtree[dir_new], p);
+    qt->subtree[dir_new] = new_quadtree(a, ccx, ccy, hs);
+  insert_quadtree(a, qt->subtree[dir_new], g, p);
 }
 
 // Compute repulsive forces (k^2 / dist)
-void compute_force(Node* target, QuadTree* qt, double theta,
+void compute_force(Graph* g, int target, QuadTree* qt, double theta,
                    double k, int* topo_dist_row, int d)
 {
   if (!qt || qt->mass == 0 || qt->node == target)
     return;
 
-  double dx = qt->mx - target->x,
-         dy = qt->my - target->y;
+  double dx = qt->mx - g->x[target],
+         dy = qt->my - g->y[target];
   double dist = sqrt(dx*dx + dy*dy);
   if (dist < DIST_EPS)
     dist = DIST_EPS;
 
-  if ((qt->size / dist) < theta || qt->node != NULL) {
+  if ((qt->size / dist) < theta || qt->node >= 0) {
     // Topological modulation (only if node != NULL)
-    int topo_dist = (qt->node != NULL ? topo_dist_row[qt->node->id] : 1);
+    int topo_dist = (qt->node >= 0 ? topo_dist_row[qt->node] : 1);
     if (topo_dist <= 0)
       topo_dist = 1;
     double factor = 1.0 / pow(topo_dist, d);
     double f = k*k*qt->mass * factor / dist;
-    target->dx += - dx/dist * f;
-    target->dy += - dy/dist * f;
+    g->dx[target] += - dx/dist * f;
+    g->dy[target] += - dy/dist * f;
   }
   else {
     for (int dir = 0; dir < 4; dir++)
-      compute_force(target, qt->subtree[dir], theta, k, topo_dist_row, d);
-  }
-}
-
-void free_quadtree(QuadTree* qt)
-{
-  for (int dir = 0; dir < 4; dir++) {
-    if (qt->subtree[dir])
-      free_quadtree(qt->subtree[dir]);
+      compute_force(g, target, qt->subtree[dir], theta, k, topo_dist_row, d);
   }
-  free(qt);
 }
 
 static void apply_node_edge_repulsion(Graph* g, double k,
@@ -149,15 +151,13 @@ static void apply_node_edge_repulsion(Graph* g, double k,
   double strength = repulsion_strength * k * k;
 
   for (int u = 0; u < g->n; u++) {
-    Node* nu = &g->nodes[u];
-    for (int jj = 0; jj < nu->degree; jj++) {
-      int v = nu->neighbors[jj];
+    for (int jj = 0; jj < g->degree[u]; jj++) {
+      int v = g->neighbors[u][jj];
       if (v <= u)
         continue; // each edge once
 
-      Node* nv = &g->nodes[v];
-      double ex = nv->x - nu->x;
-      double ey = nv->y - nu->y;
+      double ex = g->x[v] - g->x[u];
+      double ey = g->y[v] - g->y[u];
       double edge_len2 = ex * ex + ey * ey;
       if (edge_len2 < DIST_EPS)
         continue;
@@ -166,17 +166,16 @@ static void apply_node_edge_repulsion(Graph* g, double k,
         if (p == u || p == v)
           continue;
 
-        Node* np = &g->nodes[p];
-        double px = np->x - nu->x;
-        double py = np->y - nu->y;
+        double px = g->x[p] - g->x[u];
+        double py = g->y[p] - g->y[u];
         double alpha = (px * ex + py * ey) / edge_len2;
         if (alpha <= 0.0 || alpha >= 1.0)
           continue; // closest point outside segment
 
-        double qx = nu->x + alpha * ex;
-        double qy = nu->y + alpha * ey;
-        double dx = np->x - qx;
-        double dy = np->y - qy;
+        double qx = g->x[u] + alpha * ex;
+        double qy = g->y[u] + alpha * ey;
+        double dx = g->x[p] - qx;
+        double dy = g->y[p] - qy;
         double d2 = dx * dx + dy * dy;
         if (d2 >= cutoff2)
           continue;
@@ -190,171 +189,635 @@ static void apply_node_edge_repulsion(Graph* g, double k,
         double fx = (dx / dist) * f;
         double fy = (dy / dist) * f;
 
-        np->dx += fx;
-        np->dy += fy;
+        g->dx[p] += fx;
+        g->dy[p] += fy;
 
         // Split opposite reaction on edge endpoints by barycentric weights.
-        nu->dx -= fx * (1.0 - alpha);
-        nu->dy -= fy * (1.0 - alpha);
-        nv->dx -= fx * alpha;
-        nv->dy -= fy * alpha;
+        g->dx[u] -= fx * (1.0 - alpha);
+        g->dy[u] -= fy * (1.0 - alpha);
+        g->dx[v] -= fx * alpha;
+        g->dy[v] -= fy * alpha;
       }
     }
   }
 }
 
-void spring_layout(Graph* g, int max_iter, int d, double grav_strength,
-                   double node_edge_repulsion, double node_edge_cutoff_factor)
+// Renumber nodes along the Hilbert curve of current positions, so that
+// spatial neighbors (quadtree cells) are also close in memory.
+// order[i] = original index of current node i, updated.
+static void spatial_resort(Graph* g, int** graph_dist, int* order)
 {
-  if (g == NULL || g->n <= 1)
-    return;
-
-  // Negative values mean: use internal defaults.
-  if (node_edge_repulsion < 0.0)
-    node_edge_repulsion = DEFAULT_NODE_EDGE_REPULSION;
-  if (node_edge_cutoff_factor < 0.0)
-    node_edge_cutoff_factor = DEFAULT_NODE_EDGE_CUTOFF_FACTOR;
+  int* perm = graph_order(g, ORDER_HILBERT);
+  permute_graph(g, perm);
+  int* tmp = malloc(g->n * sizeof(int));
+  int** rows = malloc(g->n * sizeof(int*));
+  for (int i = 0; i < g->n; i++) {
+    rows[i] = graph_dist[perm[i]];
+    tmp[i] = order[perm[i]];
+  }
+  memcpy(order, tmp, g->n * sizeof(int));
+  for (int i = 0; i < g->n; i++) {
+    graph_dist[i] = rows[i];
+    for (int j = 0; j < g->n; j++)
+      tmp[j] = rows[i][perm[j]];
+    memcpy(rows[i], tmp, g->n * sizeof(int));
+  }
+  free(rows);
+  free(tmp);
+  free(perm);
+}
 
-  // Pre-compute all graph distances
-  int** graph_dist = malloc(g->n * sizeof(int*));
+// Graph distances from every node (INT_MAX if unreachable)
+static int** all_distances(Graph* g)
+{
+  int** dist = malloc(g->n * sizeof(int*));
   for (int i = 0; i < g->n; i++) {
-    graph_dist[i] = malloc(g->n * sizeof(int));
-    bfs(g, i, graph_dist[i]);
+    dist[i] = malloc(g->n * sizeof(int));
+    bfs(g, i, dist[i]);
   }
+  return dist;
+}
 
-  double t = -1.0; //will be set later
+// Negative values mean: use internal defaults.
+static void resolve_defaults(LayoutParams* p)
+{
+  if (p->node_edge_repulsion < 0.0)
+    p->node_edge_repulsion = DEFAULT_NODE_EDGE_REPULSION;
+  if (p->node_edge_cutoff_factor < 0.0)
+    p->node_edge_cutoff_factor = DEFAULT_NODE_EDGE_CUTOFF_FACTOR;
+}
+
+// State without distances, params with defaults resolved
+static LayoutState* new_state(Graph* g, const LayoutParams* p)
+{
+  LayoutState* s = calloc(1, sizeof(LayoutState));
+  s->g = g;
+  s->params = *p;
+  resolve_defaults(&s->params);
+  s->t = -1.0; //will be set later
+  s->quad_arena = new_arena();
+  return s;
+}
+
+LayoutState* layout_init(Graph* g, const LayoutParams* p)
+{
+  if (g == NULL || g->n <= 1)
+    return NULL;
+  LayoutState* s = new_state(g, p);
+  // Pre-compute all graph distances
+  s->dist = all_distances(g);
 
   // Initial target square from current positions.
   double minx0 = +INFINITY, maxx0 = -INFINITY,
          miny0 = +INFINITY, maxy0 = -INFINITY;
   for (int i = 0; i < g->n; i++) {
-    if (g->nodes[i].x < minx0)
-      minx0 = g->nodes[i].x;
-    if (g->nodes[i].x > maxx0)
-      maxx0 = g->nodes[i].x;
-    if (g->nodes[i].y < miny0)
-      miny0 = g->nodes[i].y;
-    if (g->nodes[i].y > maxy0)
-      maxy0 = g->nodes[i].y;
-  }
-  double target_cx = 0.5 * (minx0 + maxx0);
-  double target_cy = 0.5 * (miny0 + maxy0);
-  double target_size = fmax(maxx0 - minx0, maxy0 - miny0);
-  if (target_size < 1.0)
-    target_size = 1.0;
-  target_size *= 1.10; // initial margin
-  const double base_target_size = target_size;
-
-  for (int iter=0; iter < max_iter; iter++) {
-    double maxDelta = 0.0;
-    for (int i=0; i < g->n; i++)
-      g->nodes[i].dx = g->nodes[i].dy = 0;
-
-    // Current occupied box
-    double minx = +INFINITY, maxx = -INFINITY,
-           miny = +INFINITY, maxy = -INFINITY;
-    for (int i = 0; i < g->n; i++) {
-      if (g->nodes[i].x < minx)
-        minx = g->nodes[i].x;
-      if (g->nodes[i].x > maxx)
-        maxx = g->nodes[i].x;
-      if (g->nodes[i].y < miny)
-        miny = g->nodes[i].y;
-      if (g->nodes[i].y > maxy)
-        maxy = g->nodes[i].y;
+    if (g->x[i] < minx0)
+      minx0 = g->x[i];
+    if (g->x[i] > maxx0)
+      maxx0 = g->x[i];
+    if (g->y[i] < miny0)
+      miny0 = g->y[i];
+    if (g->y[i] > maxy0)
+      maxy0 = g->y[i];
+  }
+  s->target_cx = 0.5 * (minx0 + maxx0);
+  s->target_cy = 0.5 * (miny0 + maxy0);
+  s->target_size = fmax(maxx0 - minx0, maxy0 - miny0);
+  if (s->target_size < 1.0)
+    s->target_size = 1.0;
+  s->target_size *= 1.10; // initial margin
+  s->base_target_size = s->target_size;
+
+  // Current node i was originally node order[i] (changes if reordering)
+  if (p->reorder_period > 0) {
+    s->order = malloc(g->n * sizeof(int));
+    for (int i = 0; i < g->n; i++)
+      s->order[i] = i;
+  }
+  return s;
+}
+
+bool layout_step(LayoutState* s)
+{
+  Graph* g = s->g;
+  const LayoutParams* p = &s->params;
+  if (s->converged || s->iter >= p->max_iter)
+    return false;
+
+  double maxDelta = 0.0;
+  if (p->reorder_period > 0 && s->iter % p->reorder_period == 0)
+    spatial_resort(g, s->dist, s->order);
+  for (int i=0; i < g->n; i++)
+    g->dx[i] = g->dy[i] = 0;
+
+  // Current occupied box
+  double minx = +INFINITY, maxx = -INFINITY,
+         miny = +INFINITY, maxy = -INFINITY;
+  for (int i = 0; i < g->n; i++) {
+    if (g->x[i] < minx)
+      minx = g->x[i];
+    if (g->x[i] > maxx)
+      maxx = g->x[i];
+    if (g->y[i] < miny)
+      miny = g->y[i];
+    if (g->y[i] > maxy)
+      maxy = g->y[i];
+  }
+  double deltax = maxx - minx, deltay = maxy - miny;
+  double occupied = fmax(deltax, deltay);
+  if (occupied < 1.0)
+    occupied = 1.0;
+
+  // Barnes-Hut square follows current cloud (stable approximation).
+  double width = occupied * 1.10; // local margin
+  double centerx = 0.5 * (minx + maxx);
+  double centery = 0.5 * (miny + maxy);
+
+  // Construire le quadtree (nodes from the previous one are recycled)
+  arena_reset(s->quad_arena);
+  QuadTree* qt = new_quadtree(s->quad_arena, centerx, centery, width);
+  for (int i=0; i < g->n; i++)
+    insert_quadtree(s->quad_arena, qt, g, i);
+
+  // Keep target square size adaptive (no geometric forcing on points).
+  double desired_size = occupied * 1.20;
+  if (desired_size < s->base_target_size)
+    desired_size = s->base_target_size;
+  double max_size = s->base_target_size * MAX_GLOBAL_GROWTH;
+  if (desired_size > max_size)
+    desired_size = max_size;
+  if (desired_size > s->target_size)
+    s->target_size = fmin(s->target_size * MAX_GROWTH_PER_ITER, desired_size);
+  else
+    s->target_size = fmax(s->target_size / MAX_GROWTH_PER_ITER, desired_size);
+
+  // Forces répulsives via Barnes-Hut
+  double k = s->target_size / sqrt(g->n);
+  for (int i = 0; i < g->n; i++)
+    compute_force(g, i, qt, THETA, k, s->dist[i], p->d);
+
+  // Forces attractives (each undirected edge once)
+  for (int i = 0; i < g->n; i++) {
+    for (int j = 0; j < g->degree[i]; j++) {
+      int nb = g->neighbors[i][j];
+      if (nb <= i)
+        continue;
+      double dx = g->x[nb] - g->x[i];
+      double dy = g->y[nb] - g->y[i];
+      double dist = sqrt(dx*dx + dy*dy);
+      if (dist < DIST_EPS)
+        dist = DIST_EPS;
+      double f = dist*dist / k;
+      g->dx[i] += dx/dist*f; g->dy[i] += dy/dist*f;
+      g->dx[nb] -= dx/dist*f; g->dy[nb] -= dy/dist*f;
     }
-    double deltax = maxx - minx, deltay = maxy - miny;
-    double occupied = fmax(deltax, deltay);
-    if (occupied < 1.0)
-      occupied = 1.0;
-
-    // Barnes-Hut square follows current cloud (stable approximation).
-    double width = occupied * 1.10; // local margin
-    double centerx = 0.5 * (minx + maxx);
-    double centery = 0.5 * (miny + maxy);
-
-    // Construire le quadtree
-    QuadTree* qt = new_quadtree(centerx, centery, width);
-    for (int i=0; i < g->n; i++)
-      insert_quadtree(qt, &g->nodes[i]);
-
-    // Keep target square size adaptive (no geometric forcing on points).
-    double desired_size = occupied * 1.20;
-    if (desired_size < base_target_size)
-      desired_size = base_target_size;
-    double max_size = base_target_size * MAX_GLOBAL_GROWTH;
-    if (desired_size > max_size)
-      desired_size = max_size;
-    if (desired_size > target_size)
-      target_size = fmin(target_size * MAX_GROWTH_PER_ITER, desired_size);
-    else
-      target_size = fmax(target_size / MAX_GROWTH_PER_ITER, desired_size);
+  }
 
-    // Forces répulsives via Barnes-Hut
-    double k = target_size / sqrt(g->n);
-    for (int i = 0; i < g->n; i++)
-      compute_force(&g->nodes[i], qt, THETA, k, graph_dist[i], d);
+  // Anti-crossing term: keep nodes away from non-incident edges.
+  apply_node_edge_repulsion(g, k, p->node_edge_cutoff_factor,
+                            p->node_edge_repulsion);
 
-    // Forces attractives (each undirected edge once)
-    for (int i = 0; i < g->n; i++) {
-      for (int j = 0; j < g->nodes[i].degree; j++) {
-        int nb = g->nodes[i].neighbors[j];
-        if (nb <= i)
-          continue;
-        Node* u = &g->nodes[i];
-        Node* v = &g->nodes[nb];
-        double dx = v->x - u->x;
-        double dy = v->y - u->y;
-        double dist = sqrt(dx*dx + dy*dy);
-        if (dist < DIST_EPS)
-          dist = DIST_EPS;
-        double f = dist*dist / k;
-        u->dx += dx/dist*f; u->dy += dy/dist*f;
-        v->dx -= dx/dist*f; v->dy -= dy/dist*f;
-      }
+  // Gravité vers le centre
+  for (int i = 0; i < g->n; i++) {
+    double gx = s->target_cx - g->x[i];
+    double gy = s->target_cy - g->y[i];
+    g->dx[i] += gx * p->grav_strength * k;
+    g->dy[i] += gy * p->grav_strength * k;
+  }
+
+  // Appliquer déplacements
+  if (s->t < 0.0)
+    s->t = INIT_TEMP_FACTOR * k;
+  double t = s->t;
+  for (int i=0; i < g->n; i++) {
+    double dx = g->dx[i],
+           dy = g->dy[i];
+    double disp = sqrt(dx*dx + dy*dy);
+    if (disp > MIN_DELTA) {
+      double deltaX = dx/disp * fmin(disp, t),
+             deltaY = dy/disp * fmin(disp, t);
+      g->x[i] += deltaX;
+      g->y[i] += deltaY;
+      double delta = sqrt(deltaX*deltaX + deltaY*deltaY);
+      if (delta > maxDelta)
+        maxDelta = delta;
     }
+  }
+
+  // If cloud collapses too much, very slightly reheat by slowing cooling.
+  double occupancy_ratio = occupied / s->target_size;
+  if (occupancy_ratio < MIN_FILL_RATIO)
+    s->t /= COOLING;
+
+  s->t *= COOLING;
+  s->iter++;
+  s->max_delta = maxDelta;
+  s->converged = (maxDelta < EPS);
+  if (s->frames != NULL)
+    publish_layout_frame(s->frames, g, s->order);
+  return true;
+}
 
-    // Anti-crossing term: keep nodes away from non-incident edges.
-    apply_node_edge_repulsion(g, k, node_edge_cutoff_factor, node_edge_repulsion);
+void layout_set_params(LayoutState* s, const LayoutParams* p)
+{
+  s->params = *p;
+  resolve_defaults(&s->params);
+  if (p->reorder_period > 0 && s->order == NULL) {
+    s->order = malloc(s->g->n * sizeof(int));
+    for (int i = 0; i < s->g->n; i++)
+      s->order[i] = i;
+  }
+  s->converged = false;
+}
 
-    // Gravité vers le centre
-    for (int i = 0; i < g->n; i++) {
-      double gx = target_cx - g->nodes[i].x;
-      double gy = target_cy - g->nodes[i].y;
-      g->nodes[i].dx += gx * grav_strength * k;
-      g->nodes[i].dy += gy * grav_strength * k;
+void layout_free(LayoutState* s)
+{
+  if (s == NULL)
+    return;
+  Graph* g = s->g;
+  if (s->order != NULL) {
+    // Back to the caller's numbering
+    int* inv = malloc(g->n * sizeof(int));
+    for (int i = 0; i < g->n; i++)
+      inv[s->order[i]] = i;
+    permute_graph(g, inv);
+    free(inv);
+    free(s->order);
+  }
+  for (int i = 0; i < g->n; i++)
+    free(s->dist[i]);
+  free(s->dist);
+  arena_free(s->quad_arena);
+  free(s);
+}
+
+void spring_layout(Graph* g, int max_iter, int d, double grav_strength,
+                   double node_edge_repulsion, double node_edge_cutoff_factor,
+                   int reorder_period)
+{
+  LayoutParams p = {max_iter, d, grav_strength, node_edge_repulsion,
+                    node_edge_cutoff_factor, reorder_period};
+  LayoutState* s = layout_init(g, &p);
+  if (s == NULL)
+    return;
+  while (layout_step(s));
+  layout_free(s);
+}
+
+/////////////////////////////
+// Frames for concurrent readers
+/////////////////////////////
+
+// Frame e is in buf[e & 1]; the writer fills the other buffer, then
+// publishes. seq[b] is odd while buf[b] is being written. Each buffer
+// carries its frame number: a slow reader may copy a frame published
+// after the epoch it loaded, and must return that one.
+struct LayoutFrames {
+  int n;
+  double* buf[2];
+  atomic_uint seq[2];
+  atomic_uint_least64_t frame[2];
+  atomic_uint_least64_t epoch;
+};
+
+LayoutFrames* new_layout_frames(const Graph* g)
+{
+  LayoutFrames* f = malloc(sizeof(LayoutFrames));
+  f->n = g->n;
+  for (int b = 0; b < 2; b++) {
+    f->buf[b] = malloc(2 * (size_t)(g->n > 0 ? g->n : 1) * sizeof(double));
+    atomic_init(&f->seq[b], 0);
+    atomic_init(&f->frame[b], 0);
+  }
+  atomic_init(&f->epoch, 0);
+  for (int i = 0; i < g->n; i++) {
+    f->buf[0][2*i] = g->x[i];
+    f->buf[0][2*i + 1] = g->y[i];
+  }
+  return f;
+}
+
+void publish_layout_frame(LayoutFrames* f, const Graph* g, const int* order)
+{
+  uint64_t e = atomic_load_explicit(&f->epoch, memory_order_relaxed);
+  int b = (e + 1) & 1;
+  double* out = f->buf[b];
+  atomic_fetch_add_explicit(&f->seq[b], 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&f->frame[b], e + 1, memory_order_relaxed);
+  for (int i = 0; i < f->n; i++) {
+    int k = (order != NULL ? order[i] : i);
+    out[2*k] = g->x[i];
+    out[2*k + 1] = g->y[i];
+  }
+  atomic_fetch_add_explicit(&f->seq[b], 1, memory_order_release);
+  atomic_store_explicit(&f->epoch, e + 1, memory_order_release);
+}
+
+uint64_t read_layout_frame(const LayoutFrames* f, double* out)
+{
+  // Retry only if the writer came back to this buffer meanwhile (an
+  // iteration later)
+  for (;;) {
+    uint64_t e = atomic_load_explicit(&f->epoch, memory_order_acquire);
+    int b = e & 1;
+    unsigned s1 = atomic_load_explicit(&f->seq[b], memory_order_acquire);
+    if (s1 & 1)
+      continue;
+    memcpy(out, f->buf[b], 2 * (size_t)f->n * sizeof(double));
+    uint64_t number = atomic_load_explicit(&f->frame[b], memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&f->seq[b], memory_order_relaxed) == s1)
+      return number;
+  }
+}
+
+void free_layout_frames(LayoutFrames* f)
+{
+  if (f == NULL)
+    return;
+  free(f->buf[0]);
+  free(f->buf[1]);
+  free(f);
+}
+
+/////////////////////////////
+// Checkpoints
+/////////////////////////////
+
+// Header, then x and y (float64, n each), order (int32, n) if any, then
+// distances row by row on dist_bytes each (largest code = unreachable).
+typedef struct LayoutHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t dist_bytes; //0 if distances not stored
+  int64_t n;
+  int64_t nb_targets; //sum of degrees, checked on resume
+  int32_t max_iter, d, reorder_period, iter;
+  int32_t converged, has_order;
+  double grav_strength, node_edge_repulsion, node_edge_cutoff_factor;
+  double t, target_cx, target_cy, target_size, base_target_size, max_delta;
+} LayoutHeader;
+
+static int64_t sum_degrees(const Graph* g)
+{
+  int64_t m = 0;
+  for (int i = 0; i < g->n; i++)
+    m += g->degree[i];
+  return m;
+}
+
+// Smallest width coding all finite distances, the largest code left for
+// unreachable nodes
+static uint32_t dist_width(const LayoutState* s)
+{
+  int dmax = 0;
+  for (int i = 0; i < s->g->n; i++) {
+    for (int j = 0; j < s->g->n; j++) {
+      if (s->dist[i][j] != INT_MAX && s->dist[i][j] > dmax)
+        dmax = s->dist[i][j];
     }
+  }
+  return (dmax < UINT8_MAX ? 1 : dmax < UINT16_MAX ? 2 : 4);
+}
 
-    // Appliquer déplacements
-    if (t < 0.0)
-      t = INIT_TEMP_FACTOR * k;
-    for (int i=0; i < g->n; i++) {
-      double dx = g->nodes[i].dx,
-             dy = g->nodes[i].dy;
-      double disp = sqrt(dx*dx + dy*dy);
-      if (disp > MIN_DELTA) {
-        double deltaX = dx/disp * fmin(disp, t),
-               deltaY = dy/disp * fmin(disp, t);
-        g->nodes[i].x += deltaX;
-        g->nodes[i].y += deltaY;
-        double delta = sqrt(deltaX*deltaX + deltaY*deltaY);
-        if (delta > maxDelta)
-          maxDelta = delta;
+static bool write_dist(FILE* f, const LayoutState* s, uint32_t bytes)
+{
+  int n = s->g->n;
+  void* row = malloc((size_t)n * bytes);
+  bool ok = true;
+  for (int i = 0; ok && i < n; i++) {
+    const int* d = s->dist[i];
+    if (bytes == 1) {
+      for (int j = 0; j < n; j++)
+        ((uint8_t*)row)[j] = (d[j] == INT_MAX ? UINT8_MAX : d[j]);
+    }
+    else if (bytes == 2) {
+      for (int j = 0; j < n; j++)
+        ((uint16_t*)row)[j] = (d[j] == INT_MAX ? UINT16_MAX : d[j]);
+    }
+    else
+      memcpy(row, d, (size_t)n * sizeof(int));
+    ok = fwrite(row, bytes, n, f) == (size_t)n;
+  }
+  free(row);
+  return ok;
+}
+
+static bool read_dist(FILE* f, LayoutState* s, uint32_t bytes)
+{
+  int n = s->g->n;
+  void* row = malloc((size_t)n * bytes);
+  s->dist = calloc(n, sizeof(int*));
+  bool ok = true;
+  for (int i = 0; ok && i < n; i++) {
+    int* d = s->dist[i] = malloc(n * sizeof(int));
+    ok = fread(row, bytes, n, f) == (size_t)n;
+    if (ok && bytes == 1) {
+      for (int j = 0; j < n; j++) {
+        uint8_t v = ((uint8_t*)row)[j];
+        d[j] = (v == UINT8_MAX ? INT_MAX : v);
+      }
+    }
+    else if (ok && bytes == 2) {
+      for (int j = 0; j < n; j++) {
+        uint16_t v = ((uint16_t*)row)[j];
+        d[j] = (v == UINT16_MAX ? INT_MAX : v);
       }
     }
+    else if (ok)
+      memcpy(d, row, (size_t)n * sizeof(int));
+  }
+  free(row);
+  return ok;
+}
 
-    // If cloud collapses too much, very slightly reheat by slowing cooling.
-    double occupancy_ratio = occupied / target_size;
-    if (occupancy_ratio < MIN_FILL_RATIO)
-      t /= COOLING;
+int layout_save(const LayoutState* s, const char* path, bool with_dist)
+{
+  const Graph* g = s->g;
+  const LayoutParams* p = &s->params;
+  LayoutHeader h;
+  memset(&h, 0, sizeof(LayoutHeader));
+  memcpy(h.magic, LAYOUT_MAGIC, 8);
+  h.version = LAYOUT_VERSION;
+  h.dist_bytes = (with_dist ? dist_width(s) : 0);
+  h.n = g->n;
+  h.nb_targets = sum_degrees(g);
+  h.max_iter = p->max_iter;
+  h.d = p->d;
+  h.reorder_period = p->reorder_period;
+  h.iter = s->iter;
+  h.converged = s->converged;
+  h.has_order = (s->order != NULL);
+  h.grav_strength = p->grav_strength;
+  h.node_edge_repulsion = p->node_edge_repulsion;
+  h.node_edge_cutoff_factor = p->node_edge_cutoff_factor;
+  h.t = s->t;
+  h.target_cx = s->target_cx;
+  h.target_cy = s->target_cy;
+  h.target_size = s->target_size;
+  h.base_target_size = s->base_target_size;
+  h.max_delta = s->max_delta;
+
+  // Write aside then rename: an interrupted save keeps the previous file
+  size_t len = strlen(path);
+  char* tmp = malloc(len + 5);
+  memcpy(tmp, path, len);
+  memcpy(tmp + len, ".tmp", 5);
+  FILE* f = fopen(tmp, "wb");
+  if (f == NULL) {
+    set_graph_error("cannot open %s for writing", tmp);
+    free(tmp);
+    return -1;
+  }
+  size_t n = g->n;
+  bool ok =
+    fwrite(&h, sizeof(LayoutHeader), 1, f) == 1 &&
+    fwrite(g->x, sizeof(double), n, f) == n &&
+    fwrite(g->y, sizeof(double), n, f) == n &&
+    (s->order == NULL || fwrite(s->order, sizeof(int), n, f) == n) &&
+    (h.dist_bytes == 0 || write_dist(f, s, h.dist_bytes));
+  ok = (fclose(f) == 0) && ok;
+  ok = ok && rename(tmp, path) == 0;
+  if (!ok) {
+    set_graph_error("write error on %s", path);
+    remove(tmp);
+  }
+  free(tmp);
+  return (ok ? 0 : -1);
+}
 
-    t *= COOLING;
-    free_quadtree(qt);
-    if (maxDelta < EPS)
-      break;
+static bool check_layout_header(const LayoutHeader* h, const Graph* g,
+                                const char* path)
+{
+  if (memcmp(h->magic, LAYOUT_MAGIC, 8) != 0) {
+    set_graph_error("%s: not a layout checkpoint", path);
+    return false;
+  }
+  if (h->version != LAYOUT_VERSION) {
+    set_graph_error("%s: unsupported version %u", path, h->version);
+    return false;
+  }
+  if (g == NULL || h->n != g->n || h->n <= 1 ||
+      h->nb_targets != sum_degrees(g)) {
+    set_graph_error("%s: saved for another graph (%lld nodes, %lld targets)",
+                    path, (long long)h->n, (long long)h->nb_targets);
+    return false;
+  }
+  if (h->dist_bytes != 0 && h->dist_bytes != 1 && h->dist_bytes != 2 &&
+      h->dist_bytes != 4) {
+    set_graph_error("%s: invalid distance width %u", path, h->dist_bytes);
+    return false;
   }
+  return true;
+}
 
-  for (int i = 0; i < g->n; i++)
-    free(graph_dist[i]);
-  free(graph_dist);
+// order must be a permutation of 0..n-1
+static bool is_permutation(const int* order, int n)
+{
+  bool* seen = calloc(n, sizeof(bool));
+  bool ok = true;
+  for (int i = 0; ok && i < n; i++) {
+    ok = order[i] >= 0 && order[i] < n && !seen[order[i]];
+    if (ok)
+      seen[order[i]] = true;
+  }
+  free(seen);
+  return ok;
+}
+
+LayoutState* layout_resume(Graph* g, const char* path)
+{
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    set_graph_error("cannot open %s", path);
+    return NULL;
+  }
+  LayoutHeader h;
+  if (fread(&h, sizeof(LayoutHeader), 1, f) != 1) {
+    set_graph_error("%s: not a layout checkpoint", path);
+    fclose(f);
+    return NULL;
+  }
+  if (!check_layout_header(&h, g, path)) {
+    fclose(f);
+    return NULL;
+  }
+  LayoutParams p = {h.max_iter, h.d, h.grav_strength, h.node_edge_repulsion,
+                    h.node_edge_cutoff_factor, h.reorder_period};
+  size_t n = g->n;
+  double* pos = malloc(2 * n * sizeof(double));
+  int* order = (h.has_order ? malloc(n * sizeof(int)) : NULL);
+  bool ok = fread(pos, sizeof(double), 2 * n, f) == 2 * n &&
+    (order == NULL || fread(order, sizeof(int), n, f) == n);
+  if (!ok)
+    set_graph_error("%s: truncated file", path);
+  else if (order != NULL && !is_permutation(order, g->n)) {
+    set_graph_error("%s: invalid node order", path);
+    ok = false;
+  }
+  if (!ok) {
+    free(pos);
+    free(order);
+    fclose(f);
+    return NULL;
+  }
+
+  LayoutState* s = new_state(g, &p);
+  s->iter = h.iter;
+  s->converged = h.converged;
+  s->t = h.t;
+  s->target_cx = h.target_cx;
+  s->target_cy = h.target_cy;
+  s->target_size = h.target_size;
+  s->base_target_size = h.base_target_size;
+  s->max_delta = h.max_delta;
+  // Saved positions are in the numbering reached by the run
+  if (order != NULL) {
+    permute_graph(g, order);
+    s->order = order;
+  }
+  memcpy(g->x, pos, n * sizeof(double));
+  memcpy(g->y, pos + n, n * sizeof(double));
+  free(pos);
+  if (h.dist_bytes == 0)
+    s->dist = all_distances(g);
+  else if (!read_dist(f, s, h.dist_bytes)) {
+    set_graph_error("%s: truncated file", path);
+    ok = false;
+  }
+  fclose(f);
+  if (!ok) {
+    layout_free(s); //restores the numbering
+    return NULL;
+  }
+  return s;
+}
+
+int spring_layout_checkpointed(Graph* g, const LayoutParams* p,
+                               const char* checkpoint, int period,
+                               bool with_dist, bool resume)
+{
+  LayoutState* s;
+  if (resume && access(checkpoint, F_OK) == 0) {
+    s = layout_resume(g, checkpoint);
+    if (s == NULL)
+      return -1;
+  }
+  else {
+    s = layout_init(g, p);
+    if (s == NULL)
+      return 0;
+  }
+  int saved = s->iter, res = 0;
+  while (res == 0 && layout_step(s)) {
+    if (period > 0 && s->iter % period == 0) {
+      res = layout_save(s, checkpoint, with_dist);
+      saved = s->iter;
+    }
+  }
+  if (res == 0 && saved != s->iter)
+    res = layout_save(s, checkpoint, with_dist);
+  layout_free(s);
+  return res;
 }
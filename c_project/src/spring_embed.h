@@ -1,6 +1,8 @@
 #ifndef GREM_SPRING_EMBED_H
 #define GREM_SPRING_EMBED_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "graph.h"
 
 typedef struct QuadTree {
@@ -8,13 +10,86 @@ typedef struct QuadTree {
   double size; //longueur du côté
   int mass; //masse totale (nb de points)
   double mx, my; //centre de masse
-  Node* node; //point contenu (ou NULL)
+  int node; //point contenu (ou -1)
   struct QuadTree* subtree[4]; //NW, NE, SW, SE
 } QuadTree;
 
 // Fonction principale
 // node_edge_* < 0.0 -> default values. Use 0.0 to disable node-edge term.
+// reorder_period > 0: renumber nodes by spatial position every
+// reorder_period iterations (memory locality); original order is restored.
 void spring_layout(Graph* g, int max_iter, int d, double grav_strength,
-                   double node_edge_repulsion, double node_edge_cutoff_factor);
+                   double node_edge_repulsion, double node_edge_cutoff_factor,
+                   int reorder_period);
+
+// Same arguments as spring_layout()
+typedef struct LayoutParams {
+  int max_iter;
+  int d;
+  double grav_strength;
+  double node_edge_repulsion;
+  double node_edge_cutoff_factor;
+  int reorder_period;
+} LayoutParams;
+
+// Everything the layout carries from one iteration to the next
+typedef struct LayoutState {
+  Graph* g; //renumbered while running if params.reorder_period > 0
+  LayoutParams params;
+  int** dist; //graph distances, rows and columns in current numbering
+  int* order; //current node i was node order[i] (NULL if no reordering)
+  int iter; //iterations done
+  bool converged;
+  double t; //temperature (< 0.0 until first iteration)
+  double target_cx, target_cy;
+  double target_size, base_target_size;
+  double max_delta; //largest move at last iteration
+  struct LayoutFrames* frames; //if not NULL, published after each iteration
+  Arena* quad_arena; //quadtree nodes, recycled at each iteration
+} LayoutState;
+
+// Step by step layout: spring_layout() is
+//   s = layout_init(g, p); while (layout_step(s)); layout_free(s);
+// layout_init() returns NULL if there is nothing to do (n <= 1).
+LayoutState* layout_init(Graph* g, const LayoutParams* p);
+// Run one iteration. Returns false once finished (no iteration then)
+bool layout_step(LayoutState* s);
+// Change parameters between iterations (temperature and target square
+// are kept). The layout is no longer considered converged.
+void layout_set_params(LayoutState* s, const LayoutParams* p);
+// Restore the original numbering of the graph, and free the state
+void layout_free(LayoutState* s);
+
+// Positions for concurrent readers, in the caller's numbering: two
+// buffers under sequence counters (seqlock). The writer never waits,
+// readers take no lock and get the latest complete frame. Frames do not
+// depend on the state: readers may go on after layout_free().
+typedef struct LayoutFrames LayoutFrames;
+// First frame: current positions
+LayoutFrames* new_layout_frames(const Graph* g);
+// Single writer. order as in LayoutState (NULL: identity)
+void publish_layout_frame(LayoutFrames* f, const Graph* g, const int* order);
+// Copy the latest frame to out (x0, y0, x1, y1...), return its number
+// (frames published after the first one)
+uint64_t read_layout_frame(const LayoutFrames* f, double* out);
+void free_layout_frames(LayoutFrames* f);
+
+// Checkpoint: parameters, counters, temperature, target square, positions,
+// order, and optionally distances (1, 2 or 4 bytes each) to a binary file.
+// The file is replaced atomically. Returns 0 on success, -1 on error
+// (message from graph_error()).
+int layout_save(const LayoutState* s, const char* path, bool with_dist);
+// Continue a layout saved by layout_save() on the same graph (same
+// topology and numbering; its positions are overwritten). Subsequent
+// iterations are bit-identical to those of the saved run. Distances are
+// recomputed if they were not stored. NULL on error.
+LayoutState* layout_resume(Graph* g, const char* path);
+
+// spring_layout() saving its state to checkpoint every period iterations
+// and when finished, starting from that file if resume is true.
+// Returns 0 on success, -1 on error (graph_error()).
+int spring_layout_checkpointed(Graph* g, const LayoutParams* p,
+                               const char* checkpoint, int period,
+                               bool with_dist, bool resume);
 
 #endif
@@ -0,0 +1,43 @@
+#include <stdint.h>
+#include "utest.h"
+#include "../src/arena.h"
+
+UTEST(arena, alloc_grow) {
+  Arena* a = new_arena();
+  int* v = arena_alloc(a, 4 * sizeof(int));
+  for (int i = 0; i < 4; i++)
+    v[i] = i;
+  v = arena_grow(a, v, 4 * sizeof(int), 1000000 * sizeof(int));
+  for (int i = 0; i < 4; i++)
+    ASSERT_EQ(i, v[i]);
+  double* d = arena_alloc_aligned(a, 100 * sizeof(double), 64);
+  ASSERT_EQ((uintptr_t)0, (uintptr_t)d % 64);
+  arena_free(a);
+}
+
+UTEST(arena, huge_pages) {
+  arena_use_huge_pages(true);
+  Arena* a = new_arena();
+  arena_use_huge_pages(false);
+  char* c = arena_alloc(a, 3 << 20);
+  c[0] = c[(3 << 20) - 1] = 1;
+  arena_free(a);
+}
+
+UTEST(arena, reset) {
+  Arena* a = new_arena();
+  char* firsts[3];
+  for (int round = 0; round < 3; round++) {
+    for (int k = 0; k < 1000; k++) {
+      char* c = arena_alloc(a, 1000);
+      c[0] = c[999] = (char)k;
+      if (k == 0)
+        firsts[round] = c;
+    }
+    ASSERT_EQ(0, firsts[round][0]);
+    arena_reset(a);
+  }
+  // One block of the total size after the first round, then reused
+  ASSERT_TRUE(firsts[1] == firsts[2]);
+  arena_free(a);
+}
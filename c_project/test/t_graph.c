@@ -1,6 +1,9 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
 #include "utest.h"
-#include "../src/graph.h"
+#include "../src/graph_io.h"
+#include "../src/parallel.h"
 
 UTEST(graph, read_write_graph1) {
   Graph g = make_random_graph(100, 0.2, 150, 32);
@@ -8,9 +11,9 @@ UTEST(graph, read_write_graph1) {
   Graph h = read_graph("tmpgraph");
   ASSERT_EQ(g.n, h.n);
   for (int i = 0; i < g.n; i++) {
-    ASSERT_EQ(g.nodes[i].degree, h.nodes[i].degree);
-    for (int j = 0; j < g.nodes[i].degree; j++)
-      ASSERT_EQ(g.nodes[i].neighbors[j], h.nodes[i].neighbors[j]);
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+    for (int j = 0; j < g.degree[i]; j++)
+      ASSERT_EQ(g.neighbors[i][j], h.neighbors[i][j]);
   }
   free_graph(g);
   free_graph(h);
@@ -23,11 +26,180 @@ UTEST(graph, read_write_graph2) {
   Graph h = read_graph("tmpgraph");
   ASSERT_EQ(g.n, h.n);
   for (int i = 0; i < g.n; i++) {
-    ASSERT_EQ(g.nodes[i].degree, h.nodes[i].degree);
-    for (int j = 0; j < g.nodes[i].degree; j++)
-      ASSERT_EQ(g.nodes[i].neighbors[j], h.nodes[i].neighbors[j]);
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+    for (int j = 0; j < g.degree[i]; j++)
+      ASSERT_EQ(g.neighbors[i][j], h.neighbors[i][j]);
   }
   free_graph(g);
   free_graph(h);
   remove("tmpgraph");
 }
+
+UTEST(graph, random_graph_density) {
+  int n = 2000;
+  double p = 0.01;
+  Graph g = make_random_graph(n, p, 100, 7);
+  Graph h = make_random_graph(n, p, 100, 7);
+  long m = 0;
+  for (int i = 0; i < n; i++) {
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+    for (int j = 0; j < g.degree[i]; j++) {
+      ASSERT_NE(i, g.neighbors[i][j]);
+      if (j > 0)
+        ASSERT_LT(g.neighbors[i][j-1], g.neighbors[i][j]);
+    }
+    m += g.degree[i];
+  }
+  m /= 2;
+  double expected = p * n * (n - 1) / 2;
+  ASSERT_LT(fabs(m - expected), 0.05 * expected);
+  free_graph(g);
+  free_graph(h);
+}
+
+UTEST(graph, random_graph_complete) {
+  // p >= 1: every pair once, without loops
+  double ps[2] = {1.0, 1.5};
+  for (int k = 0; k < 2; k++) {
+    Graph g = make_random_graph(50, ps[k], 100, 1);
+    for (int i = 0; i < 50; i++) {
+      ASSERT_EQ(49, g.degree[i]);
+      for (int j = 0; j < 49; j++)
+        ASSERT_EQ(j < i ? j : j + 1, g.neighbors[i][j]);
+    }
+    free_graph(g);
+  }
+}
+
+UTEST(graph, random_pa_graph) {
+  int n = 500, m = 3;
+  Graph g = make_random_pa_graph(n, m, 100, 5);
+  long sum = 0;
+  for (int i = 0; i < n; i++) {
+    if (i >= m)
+      ASSERT_GE(g.degree[i], m);
+    for (int j = 0; j < g.degree[i]; j++) {
+      ASSERT_NE(i, g.neighbors[i][j]);
+      for (int jj = 0; jj < j; jj++)
+        ASSERT_NE(g.neighbors[i][jj], g.neighbors[i][j]);
+    }
+    sum += g.degree[i];
+  }
+  ASSERT_EQ((long)2 * (n - m) * m, sum);
+  free_graph(g);
+}
+
+UTEST(graph, remy_binary_tree) {
+  Graph g = make_remy_binary_tree(1001, 100, 3);
+  ASSERT_EQ(1001, g.n);
+  ASSERT_EQ(1000, g.size[0]);
+  int leaves = 0;
+  for (int i = 0; i < g.n; i++) {
+    int children = g.degree[i] - (i == 0 ? 0 : 1);
+    ASSERT_TRUE(children == 0 || children == 2);
+    if (i > 0)
+      ASSERT_LT(g.neighbors[i][0], i);
+    if (children == 0)
+      leaves++;
+  }
+  ASSERT_EQ(501, leaves);
+  free_graph(g);
+}
+
+// Probability to descend into child j of a node with children sizes fs
+// (k of them, sum f), as computed before grow_nary_tree() kept sumSq
+static double nary_child_prob_ref(const double* fs, int k, int j,
+                                  double alpha)
+{
+  double f = 0.0, sumFij = 0.0;
+  for (int ii = 0; ii < k; ii++)
+    f += fs[ii];
+  for (int ii = 0; ii < k; ii++) {
+    for (int jj = 0; jj < k; jj++) {
+      if (ii != j && jj != j && ii != jj)
+        sumFij += fs[ii] * fs[jj];
+    }
+  }
+  double fj = fs[j];
+  return (alpha*fj-1) * ((fj-1)*fj*(fj+1)+3*fj*(fj+1)*(f-fj)+sumFij*(1+fj))
+    / ((alpha*f-1)*(1+fj)*(f-1)*f);
+}
+
+UTEST(graph, random_nary_tree) {
+  double alpha = 0.5;
+  Graph g = make_random_nary_tree(500, alpha, 100, 12);
+  Graph h = make_random_nary_tree(500, alpha, 100, 12);
+  ASSERT_GE(g.n, 500);
+  int leaves = 0;
+  double* fs = malloc(g.n * sizeof(double));
+  for (int i = 0; i < g.n; i++) {
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+    int start = (i == 0 ? 0 : 1);
+    int k = g.degree[i] - start;
+    if (k == 0) {
+      ASSERT_EQ(1, g.size[i]);
+      leaves++;
+      continue;
+    }
+    ASSERT_GE(k, 2);
+    // size = leaves below = sum of children sizes
+    long f = 0, sumSq = 0;
+    for (int j = 0; j < k; j++) {
+      int c = g.neighbors[i][start + j];
+      ASSERT_EQ(i, g.neighbors[c][0]);
+      fs[j] = g.size[c];
+      f += g.size[c];
+      sumSq += (long)g.size[c] * g.size[c];
+    }
+    ASSERT_EQ(f, g.size[i]);
+    // Choices at this node (new leaf at k+1 positions, or a child) sum to
+    // 1, and the closed form matches the former O(k^3) formula
+    double D = (double)(f*f - sumSq), C = 1.0 / ((alpha*f-1)*(f-1)*f);
+    double total = (k+1) * (k-alpha)*D / ((alpha*f-1)*(k+1)*((f-1)*f));
+    for (int j = 0; j < k; j++) {
+      double pj = C * (alpha*fs[j]-1) * (D + (f-1)*fs[j]);
+      ASSERT_LT(fabs(pj - nary_child_prob_ref(fs, k, j, alpha)), 1e-12);
+      total += pj;
+    }
+    ASSERT_LT(fabs(total - 1.0), 1e-9);
+  }
+  ASSERT_EQ(leaves, g.size[0]);
+  free(fs);
+  free_graph(g);
+  free_graph(h);
+}
+
+UTEST(graph, random_graph_threads) {
+  set_num_threads(1);
+  Graph g = make_random_graph(3000, 0.002, 100, 11);
+  set_num_threads(4);
+  Graph h = make_random_graph(3000, 0.002, 100, 11);
+  set_num_threads(0);
+  for (int i = 0; i < g.n; i++) {
+    ASSERT_EQ(g.x[i], h.x[i]);
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+    for (int j = 0; j < g.degree[i]; j++)
+      ASSERT_EQ(g.neighbors[i][j], h.neighbors[i][j]);
+  }
+  free_graph(g);
+  free_graph(h);
+}
+
+UTEST(graph, list_edges) {
+  Graph g = make_random_graph(500, 0.02, 100, 5);
+  long m, sum = 0;
+  int* edges = list_edges(&g, &m);
+  for (int i = 0; i < g.n; i++)
+    sum += g.degree[i];
+  ASSERT_EQ(sum, 2 * m);
+  for (long k = 0; k < m; k++) {
+    int u = edges[2*k], v = edges[2*k+1];
+    ASSERT_LT(u, v);
+    bool found = false;
+    for (int j = 0; j < g.degree[u]; j++)
+      found = found || g.neighbors[u][j] == v;
+    ASSERT_TRUE(found);
+  }
+  free(edges);
+  free_graph(g);
+}
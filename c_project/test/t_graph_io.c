@@ -0,0 +1,391 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <math.h>
+#include "utest.h"
+#include "../src/graph_io.h"
+#include "../src/parallel.h"
+
+static void check_same(int* utest_result, Graph g, Graph h)
+{
+  ASSERT_EQ(g.n, h.n);
+  for (int i = 0; i < g.n; i++) {
+    ASSERT_EQ(g.x[i], h.x[i]);
+    ASSERT_EQ(g.y[i], h.y[i]);
+    ASSERT_EQ(g.color[i], h.color[i]);
+    ASSERT_EQ(g.size[i], h.size[i]);
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+    for (int j = 0; j < g.degree[i]; j++)
+      ASSERT_EQ(g.neighbors[i][j], h.neighbors[i][j]);
+  }
+}
+
+UTEST(graph_io, binary_round_trip) {
+  Graph g = make_remy_binary_tree(301, 100, 8);
+  ASSERT_EQ(0, write_graph_binary(&g, "tmpgraph.bin"));
+  Graph h = read_graph_binary("tmpgraph.bin");
+  check_same(utest_result, g, h);
+  Graph k = map_graph_binary("tmpgraph.bin");
+  check_same(utest_result, g, k);
+  ASSERT_EQ(0, ((size_t)k.x) % 64);
+  ASSERT_EQ(k.x + k.capacity, k.y);
+  // Private mapping: changes stay in memory
+  k.x[0] += 1.0;
+  Graph l = map_graph_binary("tmpgraph.bin");
+  ASSERT_EQ(g.x[0], l.x[0]);
+  free_graph(g);
+  free_graph(h);
+  free_graph(k);
+  free_graph(l);
+  remove("tmpgraph.bin");
+}
+
+UTEST(graph_io, binary_errors) {
+  FILE* f = fopen("tmpgraph.bin", "w");
+  fprintf(f, "1 0\n0.0 0.0 0\n");
+  fclose(f);
+  Graph g = read_graph_binary("tmpgraph.bin");
+  ASSERT_EQ(-1, g.n);
+  free_graph(g);
+  g = map_graph_binary("tmpgraph.bin");
+  ASSERT_EQ(-1, g.n);
+  free_graph(g);
+  // Valid header and offsets, but a neighbor index out of range
+  g = make_random_graph(50, 0.1, 100, 2);
+  ASSERT_EQ(0, write_graph_binary(&g, "tmpgraph.bin"));
+  free_graph(g);
+  f = fopen("tmpgraph.bin", "r+b");
+  uint64_t targets; //section[SEC_TARGETS] in the header
+  fseek(f, 88, SEEK_SET);
+  ASSERT_EQ(1u, fread(&targets, sizeof(targets), 1, f));
+  int bad = 50;
+  fseek(f, (long)targets, SEEK_SET);
+  fwrite(&bad, sizeof(int), 1, f);
+  fclose(f);
+  g = map_graph_binary("tmpgraph.bin");
+  ASSERT_EQ(-1, g.n);
+  ASSERT_TRUE(strstr(graph_error(), "out of range") != NULL);
+  free_graph(g);
+  g = map_graph_binary("no/such/file");
+  ASSERT_EQ(-1, g.n);
+  ASSERT_TRUE(graph_error()[0] != '\0');
+  free_graph(g);
+  remove("tmpgraph.bin");
+}
+
+UTEST(graph_io, binary_memory) {
+  Graph g = make_random_graph(200, 0.05, 100, 3);
+  // Same bytes as the file
+  size_t len = graph_binary_size(&g);
+  char* buf = malloc(len);
+  ASSERT_EQ(-1, write_graph_binary_buffer(&g, buf, len - 1));
+  ASSERT_EQ(0, write_graph_binary_buffer(&g, buf, len));
+  ASSERT_EQ(0, write_graph_binary(&g, "tmpgraph.bin"));
+  FILE* f = fopen("tmpgraph.bin", "rb");
+  char* file = malloc(len + 1);
+  ASSERT_EQ(len, fread(file, 1, len + 1, f));
+  fclose(f);
+  ASSERT_EQ(0, memcmp(buf, file, len));
+  Graph h = read_graph_binary_buffer(buf, len);
+  check_same(utest_result, g, h);
+  free_graph(h);
+  h = read_graph_binary_buffer(buf, len - 64);
+  ASSERT_EQ(-1, h.n);
+  free_graph(h);
+  // Shared memory: attached graphs are private copies
+  const char* name = "/grem-test-shm";
+  unlink_shared_graph(name);
+  ASSERT_EQ(0, share_graph(&g, name));
+  ASSERT_EQ(-1, share_graph(&g, name));
+  Graph k = attach_graph(name);
+  check_same(utest_result, g, k);
+  k.x[0] += 1.0;
+  Graph l = attach_graph(name);
+  ASSERT_EQ(g.x[0], l.x[0]);
+  // A corrupt neighbor index is rejected like in a pickled image
+  int fd = shm_open(name, O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  char* image = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  uint64_t targets; //section[SEC_TARGETS] in the header
+  memcpy(&targets, image + 88, sizeof(targets));
+  int* first = (int*)(image + targets);
+  int saved = *first;
+  *first = g.n;
+  h = attach_graph(name);
+  ASSERT_EQ(-1, h.n);
+  ASSERT_TRUE(strstr(graph_error(), "out of range") != NULL);
+  free_graph(h);
+  *first = saved;
+  munmap(image, len);
+  ASSERT_EQ(0, unlink_shared_graph(name));
+  h = attach_graph(name);
+  ASSERT_EQ(-1, h.n);
+  free_graph(h);
+  ASSERT_EQ(-1, unlink_shared_graph(name));
+  free_graph(k);
+  free_graph(l);
+  free_graph(g);
+  free(buf);
+  free(file);
+  remove("tmpgraph.bin");
+}
+
+UTEST(graph_io, text_errors) {
+  const char* bad[] = {
+    "2 1\n0.5 1.5 0\n2.0 x 1\n0 1\n",
+    "2 1\n0.5 1.5 0\n2.0 3.0 1\n0 2\n",
+    "2 2\n0.5 1.5 0\n2.0 3.0 1\n0 1\n"
+  };
+  const char* where[] = {"tmpgraph:3:", "tmpgraph:4:", "tmpgraph:5:"};
+  for (int k = 0; k < 3; k++) {
+    FILE* f = fopen("tmpgraph", "w");
+    fputs(bad[k], f);
+    fclose(f);
+    Graph g = read_graph("tmpgraph");
+    ASSERT_EQ(-1, g.n);
+    ASSERT_EQ(0, strncmp(where[k], graph_error(), strlen(where[k])));
+    free_graph(g);
+  }
+  remove("tmpgraph");
+}
+
+UTEST(graph_io, text_numbers) {
+  FILE* f = fopen("tmpgraph", "w");
+  fputs("3 2\n-0.125 1e3 7\n  123456.789012\t.5 -1\n"
+        "0.1000000000000000055511151231257827 2.5E-3 2\n0 1\n2 1\n", f);
+  fclose(f);
+  Graph g = read_graph("tmpgraph");
+  ASSERT_EQ(3, g.n);
+  ASSERT_EQ(-0.125, g.x[0]);
+  ASSERT_EQ(1000.0, g.y[0]);
+  ASSERT_EQ(123456.789012, g.x[1]);
+  ASSERT_EQ(0.5, g.y[1]);
+  ASSERT_EQ(-1, g.color[1]);
+  ASSERT_EQ(0.1, g.x[2]);
+  ASSERT_EQ(2.5e-3, g.y[2]);
+  ASSERT_EQ(2, g.degree[1]);
+  free_graph(g);
+  remove("tmpgraph");
+}
+
+static void* write_fifo(void* arg)
+{
+  Graph* g = arg;
+  write_graph(*g, "tmpfifo");
+  return NULL;
+}
+
+UTEST(graph_io, text_chunks_and_stream) {
+  // Several chunks (> 1 MiB), parsed by several threads, then from a pipe
+  Graph g = make_random_graph(50000, 2e-4, 100, 21);
+  write_graph(g, "tmpgraph");
+  set_num_threads(4);
+  Graph h = read_graph("tmpgraph");
+  set_num_threads(0);
+  ASSERT_EQ(0, mkfifo("tmpfifo", 0600));
+  pthread_t writer;
+  pthread_create(&writer, NULL, write_fifo, &g);
+  Graph k = read_graph("tmpfifo");
+  pthread_join(writer, NULL);
+  ASSERT_EQ(g.n, h.n);
+  ASSERT_EQ(g.n, k.n);
+  for (int i = 0; i < g.n; i++) {
+    ASSERT_EQ(h.x[i], k.x[i]);
+    ASSERT_EQ(h.color[i], k.color[i]);
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+    ASSERT_EQ(g.degree[i], k.degree[i]);
+    for (int j = 0; j < g.degree[i]; j++) {
+      ASSERT_EQ(g.neighbors[i][j], h.neighbors[i][j]);
+      ASSERT_EQ(g.neighbors[i][j], k.neighbors[i][j]);
+    }
+  }
+  free_graph(g);
+  free_graph(h);
+  free_graph(k);
+  remove("tmpgraph");
+  remove("tmpfifo");
+}
+
+static void write_text(const char* path, const char* text)
+{
+  FILE* f = fopen(path, "w");
+  fputs(text, f);
+  fclose(f);
+}
+
+UTEST(graph_io, edge_list) {
+  write_text("tmpgraph", "# comment\n"
+             "1000000000000 42 0.5\n42 7\n\n7 1000000000000\n42 7\n7 7\n");
+  long long* ids;
+  Graph g = read_edge_list("tmpgraph", 100, 3, &ids);
+  ASSERT_EQ(3, g.n);
+  ASSERT_EQ(1000000000000LL, ids[0]);
+  ASSERT_EQ(42, ids[1]);
+  ASSERT_EQ(7, ids[2]);
+  for (int i = 0; i < 3; i++)
+    ASSERT_EQ(2, g.degree[i]); //triangle, duplicates and loop dropped
+  free(ids);
+  free_graph(g);
+  remove("tmpgraph");
+}
+
+UTEST(graph_io, matrix_market) {
+  write_text("tmpgraph", "%%MatrixMarket matrix coordinate real symmetric\n"
+             "% comment\n4 4 5\n1 1 2.0\n2 1 -1.0\n3 2 -1.0\n4 3 -1.0\n"
+             "3 3 2.0\n");
+  Graph g = read_matrix_market("tmpgraph", 100, 3);
+  ASSERT_EQ(4, g.n);
+  ASSERT_EQ(1, g.degree[0]);
+  ASSERT_EQ(2, g.degree[1]);
+  ASSERT_EQ(2, g.degree[2]);
+  ASSERT_EQ(2, g.neighbors[3][0]);
+  free_graph(g);
+  write_text("tmpgraph", "%%MatrixMarket matrix coordinate pattern general\n"
+             "3 4 1\n1 2\n");
+  g = read_matrix_market("tmpgraph", 100, 3);
+  ASSERT_EQ(-1, g.n);
+  free_graph(g);
+  remove("tmpgraph");
+}
+
+UTEST(graph_io, metis) {
+  // Path 1-2-3 with edge weights, and isolated node 4
+  write_text("tmpgraph", "% comment\n4 2 1\n2 5\n1 5 3 1\n2 1\n\n");
+  Graph g = read_metis("tmpgraph", 100, 3);
+  ASSERT_EQ(4, g.n);
+  ASSERT_EQ(1, g.degree[0]);
+  ASSERT_EQ(2, g.degree[1]);
+  ASSERT_EQ(1, g.degree[2]);
+  ASSERT_EQ(0, g.degree[3]);
+  ASSERT_EQ(1, g.neighbors[2][0]);
+  free_graph(g);
+  remove("tmpgraph");
+}
+
+UTEST(graph_io, compressed) {
+  Graph g = make_random_pa_graph(20000, 3, 100, 2);
+  for (int i = 0; i < g.n; i++)
+    sort_ints(g.neighbors[i], g.degree[i]);
+  ASSERT_EQ(0, write_graph_compressed(&g, "tmpgraph.z", 0.0));
+  Graph h = read_graph_compressed("tmpgraph.z");
+  check_same(utest_result, g, h);
+  free_graph(h);
+  ASSERT_EQ(0, write_graph_compressed(&g, "tmpgraph.z", 1e-3));
+  h = read_graph_compressed("tmpgraph.z");
+  ASSERT_EQ(g.n, h.n);
+  for (int i = 0; i < g.n; i++) {
+    ASSERT_LE(fabs(g.x[i] - h.x[i]), 1e-3 * (1 + 1e-9));
+    ASSERT_LE(fabs(g.y[i] - h.y[i]), 1e-3 * (1 + 1e-9));
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+  }
+  free_graph(h);
+  // Truncated file
+  FILE* f = fopen("tmpgraph.z", "r+");
+  ASSERT_EQ(0, ftruncate(fileno(f), 1000));
+  fclose(f);
+  h = read_graph_compressed("tmpgraph.z");
+  ASSERT_EQ(-1, h.n);
+  free_graph(h);
+  free_graph(g);
+  remove("tmpgraph.z");
+}
+
+UTEST(graph_io, text_writer_format) {
+  // Same bytes as printf("%f"), including ties and signs
+  double values[] = {0.0, -0.0, 0.5e-6, 1.5e-6, 2.5e-6, -0.4e-6, 123456.789012,
+                     1e15 + 0.3, -7.0000005, 0.1, 2.675, 1e22, 1e300};
+  int nb = sizeof(values) / sizeof(double);
+  Graph g = make_random_graph(nb, 0.5, 100, 2);
+  for (int i = 0; i < nb; i++) {
+    g.x[i] = values[i];
+    g.y[i] = -values[nb - 1 - i];
+  }
+  ASSERT_EQ(0, write_graph(g, "tmpgraph"));
+  FILE* f = fopen("tmpgraph", "r");
+  char* text = malloc(1 << 16);
+  size_t len = fread(text, 1, (1 << 16) - 1, f);
+  text[len] = '\0';
+  fclose(f);
+  char* expected = malloc(1 << 16);
+  int m = 0;
+  for (int i = 0; i < g.n; i++)
+    m += g.degree[i];
+  char* p = expected + sprintf(expected, "%i %i\n", g.n, m / 2);
+  for (int i = 0; i < g.n; i++)
+    p += sprintf(p, "%f %f %i\n", g.x[i], g.y[i], g.color[i]);
+  for (int i = 0; i < g.n; i++) {
+    for (int j = 0; j < g.degree[i]; j++) {
+      if (g.neighbors[i][j] > i)
+        p += sprintf(p, "%i %i\n", i, g.neighbors[i][j]);
+    }
+  }
+  ASSERT_STREQ(expected, text);
+  // Exact variant reads back the same doubles
+  ASSERT_EQ(0, write_graph_exact(g, "tmpgraph"));
+  Graph h = read_graph("tmpgraph");
+  for (int i = 0; i < nb; i++) {
+    ASSERT_EQ(g.x[i], h.x[i]);
+    ASSERT_EQ(g.y[i], h.y[i]);
+  }
+  ASSERT_EQ(-1, write_graph(g, "no/such/dir/file"));
+  free(text);
+  free(expected);
+  free_graph(g);
+  free_graph(h);
+  remove("tmpgraph");
+}
+
+UTEST(graph_io, from_arrays) {
+  Graph g = make_random_graph(300, 0.02, 100, 9);
+  // Positions interleaved, edges listed once
+  long m;
+  int* edges = list_edges(&g, &m);
+  double* pos = malloc(2 * g.n * sizeof(double));
+  int64_t* offsets = malloc((g.n + 1) * sizeof(int64_t));
+  int* targets = malloc(2 * m * sizeof(int) + 1);
+  offsets[0] = 0;
+  for (int i = 0; i < g.n; i++) {
+    pos[2*i] = g.x[i];
+    pos[2*i + 1] = g.y[i];
+    offsets[i+1] = offsets[i] + g.degree[i];
+    memcpy(targets + offsets[i], g.neighbors[i], g.degree[i] * sizeof(int));
+  }
+  Graph h = graph_from_edges(g.n, edges, m, pos, 0.0, -1);
+  ASSERT_EQ(g.n, h.n);
+  for (int i = 0; i < g.n; i++) {
+    ASSERT_EQ(g.x[i], h.x[i]);
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+  }
+  free_graph(h);
+  for (int copy = 0; copy <= 1; copy++) {
+    h = graph_from_csr(g.n, offsets, targets, pos, 0.0, -1, copy);
+    check_same(utest_result, g, h);
+    ASSERT_EQ(!copy, h.n > 0 && h.neighbors[0] == targets);
+    free_graph(h);
+  }
+  // Random positions, errors
+  h = graph_from_edges(g.n, edges, m, NULL, 10.0, 1);
+  for (int i = 0; i < h.n; i++)
+    ASSERT_TRUE(h.x[i] >= 0.0 && h.x[i] <= 10.0);
+  free_graph(h);
+  edges[1] = g.n;
+  h = graph_from_edges(g.n, edges, m, NULL, 10.0, 1);
+  ASSERT_EQ(-1, h.n);
+  ASSERT_TRUE(strstr(graph_error(), "out of range") != NULL);
+  free_graph(h);
+  offsets[2] = offsets[1] - 1;
+  h = graph_from_csr(g.n, offsets, targets, NULL, 10.0, 1, false);
+  ASSERT_EQ(-1, h.n);
+  free_graph(h);
+  free(edges);
+  free(pos);
+  free(offsets);
+  free(targets);
+  free_graph(g);
+}
@@ -0,0 +1,102 @@
+#include <math.h>
+#include "utest.h"
+#include "../src/graph_models.h"
+#include "../src/parallel.h"
+
+UTEST(graph_models, sbm_blocks) {
+  int sizes[2] = {1000, 500};
+  double probs[4] = {0.02, 0.002,
+                     0.002, 0.05};
+  set_num_threads(1);
+  Graph g = make_random_sbm_graph(2, sizes, probs, 100, 9);
+  set_num_threads(4);
+  Graph h = make_random_sbm_graph(2, sizes, probs, 100, 9);
+  set_num_threads(0);
+  ASSERT_EQ(1500, g.n);
+  long m[3] = {0, 0, 0}; //inside 0, across, inside 1
+  for (int i = 0; i < g.n; i++) {
+    ASSERT_EQ(g.degree[i], h.degree[i]);
+    for (int j = 0; j < g.degree[i]; j++) {
+      int v = g.neighbors[i][j];
+      ASSERT_EQ(v, h.neighbors[i][j]);
+      ASSERT_NE(i, v);
+      m[(i >= 1000) + (v >= 1000)]++;
+    }
+  }
+  double expected[3] = {0.02 * 1000 * 999, 2 * 0.002 * 1000 * 500,
+                        0.05 * 500 * 499};
+  for (int k = 0; k < 3; k++)
+    ASSERT_LT(fabs(m[k] - expected[k]), 0.1 * expected[k]);
+  free_graph(g);
+  free_graph(h);
+}
+
+UTEST(graph_models, chung_lu_degrees) {
+  int n = 2000;
+  double weights[2000];
+  double sum = 0.0;
+  for (int i = 0; i < n; i++) {
+    weights[i] = (i < 100 ? 40.0 : 5.0);
+    sum += weights[i];
+  }
+  Graph g = make_random_chung_lu_graph(n, weights, 100, 4);
+  long total = 0, hubs = 0;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < g.degree[i]; j++) {
+      ASSERT_NE(i, g.neighbors[i][j]);
+      if (j > 0)
+        ASSERT_LT(g.neighbors[i][j-1], g.neighbors[i][j]);
+    }
+    total += g.degree[i];
+    if (i < 100)
+      hubs += g.degree[i];
+  }
+  ASSERT_LT(total, (long)sum);
+  ASSERT_GT(total, (long)(0.9 * sum));
+  ASSERT_GT(hubs, (long)(0.8 * 40 * 100));
+  free_graph(g);
+}
+
+UTEST(graph_models, geometric_graph) {
+  int n = 800;
+  double r = 7.5;
+  Graph g = make_random_geometric_graph(n, r, 100, 13);
+  long m = 0;
+  for (int u = 0; u < n; u++) {
+    for (int v = u + 1; v < n; v++) {
+      double dx = g.x[u] - g.x[v], dy = g.y[u] - g.y[v];
+      if (dx * dx + dy * dy <= r * r)
+        m++;
+    }
+  }
+  long sum = 0;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < g.degree[i]; j++) {
+      int v = g.neighbors[i][j];
+      double dx = g.x[i] - g.x[v], dy = g.y[i] - g.y[v];
+      ASSERT_LE(dx * dx + dy * dy, r * r);
+    }
+    sum += g.degree[i];
+  }
+  ASSERT_EQ(2 * m, sum);
+  free_graph(g);
+}
+
+UTEST(graph_models, lattices) {
+  Graph g = make_grid_graph(20, 30, 100, 1);
+  Graph h = make_triangular_mesh(20, 30, 100, 1);
+  Graph k = make_torus_graph(20, 30, 100, 1);
+  long mg = 0, mh = 0, mk = 0;
+  for (int i = 0; i < 600; i++) {
+    mg += g.degree[i];
+    mh += h.degree[i];
+    mk += k.degree[i];
+    ASSERT_EQ(4, k.degree[i]);
+  }
+  ASSERT_EQ(2 * (19 * 30 + 20 * 29), mg);
+  ASSERT_EQ(2 * (19 * 30 + 20 * 29 + 19 * 29), mh);
+  ASSERT_EQ(2 * 2 * 600, mk);
+  free_graph(g);
+  free_graph(h);
+  free_graph(k);
+}
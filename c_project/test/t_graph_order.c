@@ -0,0 +1,23 @@
+#include <stdlib.h>
+#include "utest.h"
+#include "../src/graph.h"
+#include "../src/graph_order.h"
+
+UTEST(graph_order, reorder_keeps_edges) {
+  for (int mode = ORDER_RCM; mode <= ORDER_HILBERT; mode++) {
+    Graph g = make_random_graph(100, 0.05, 150, 32);
+    Graph h = make_random_graph(100, 0.05, 150, 32);
+    int* perm = reorder_graph(&h, mode);
+    for (int i = 0; i < h.n; i++) {
+      int old = perm[i];
+      ASSERT_EQ(g.color[old], h.color[i]);
+      ASSERT_EQ(g.x[old], h.x[i]);
+      ASSERT_EQ(g.degree[old], h.degree[i]);
+      for (int j = 0; j < h.degree[i]; j++)
+        ASSERT_EQ(g.neighbors[old][j], perm[h.neighbors[i][j]]);
+    }
+    free(perm);
+    free_graph(g);
+    free_graph(h);
+  }
+}
@@ -0,0 +1,28 @@
+#include "utest.h"
+#include "../src/rng.h"
+
+UTEST(rng, reproducible_streams) {
+  Rng a, b;
+  rng_init(&a, 42);
+  rng_init(&b, 42);
+  Rng a1 = rng_split(&a), b1 = rng_split(&b);
+  for (int i = 0; i < 100; i++) {
+    uint64_t x = rng_next(&a1);
+    ASSERT_EQ(x, rng_next(&b1));
+    ASSERT_NE(x, rng_next(&a));
+    rng_next(&b);
+  }
+}
+
+UTEST(rng, bounded) {
+  Rng r;
+  rng_init(&r, 1);
+  int counts[6] = {0};
+  for (int i = 0; i < 60000; i++) {
+    double u = rng_uniform(&r);
+    ASSERT_TRUE(u >= 0.0 && u < 1.0);
+    counts[rng_below(&r, 6)]++;
+  }
+  for (int j = 0; j < 6; j++)
+    ASSERT_TRUE(counts[j] > 9500 && counts[j] < 10500);
+}
@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "utest.h"
+#include "../src/graph.h"
+#include "../src/graph_io.h"
+#include "../src/spring_embed.h"
+
+// Interrupted after `stop` iterations, saved, then resumed on a fresh copy
+static void resumed_layout(Graph* g, const LayoutParams* p, int stop,
+                           const char* path, bool with_dist)
+{
+  Graph h = make_random_graph(g->n, 0.03, 100, 7);
+  LayoutState* s = layout_init(&h, p);
+  for (int i = 0; i < stop; i++)
+    layout_step(s);
+  layout_save(s, path, with_dist);
+  layout_free(s);
+  free_graph(h);
+  s = layout_resume(g, path);
+  while (layout_step(s));
+  layout_free(s);
+}
+
+UTEST(spring_embed, checkpoint_resume) {
+  const char* path = "/tmp/grem_test_layout.ckpt";
+  for (int reorder = 0; reorder <= 7; reorder += 7) {
+    LayoutParams p = {40, 2, 0.01, -1.0, -1.0, reorder};
+    Graph full = make_random_graph(150, 0.03, 100, 7);
+    spring_layout(&full, p.max_iter, p.d, p.grav_strength,
+                  p.node_edge_repulsion, p.node_edge_cutoff_factor, reorder);
+    for (int with_dist = 0; with_dist <= 1; with_dist++) {
+      Graph g = make_random_graph(150, 0.03, 100, 7);
+      resumed_layout(&g, &p, 17, path, with_dist);
+      for (int i = 0; i < g.n; i++) {
+        ASSERT_EQ(full.x[i], g.x[i]);
+        ASSERT_EQ(full.y[i], g.y[i]);
+        ASSERT_EQ(full.color[i], g.color[i]);
+      }
+      free_graph(g);
+    }
+    free_graph(full);
+  }
+  // Wrong graph
+  Graph other = make_random_graph(80, 0.05, 100, 7);
+  ASSERT_TRUE(layout_resume(&other, path) == NULL);
+  ASSERT_TRUE(strstr(graph_error(), "another graph") != NULL);
+  free_graph(other);
+  remove(path);
+}
+
+UTEST(spring_embed, checkpointed_run) {
+  const char* path = "/tmp/grem_test_layout2.ckpt";
+  remove(path);
+  LayoutParams p = {30, 2, 0.01, -1.0, -1.0, 5};
+  Graph full = make_random_graph(120, 0.04, 100, 3);
+  spring_layout(&full, 30, 2, 0.01, -1.0, -1.0, 5);
+  // First job stops at 20 (as if preempted), the second one resumes
+  Graph g = make_random_graph(120, 0.04, 100, 3);
+  p.max_iter = 20;
+  ASSERT_EQ(0, spring_layout_checkpointed(&g, &p, path, 10, true, true));
+  free_graph(g);
+  g = make_random_graph(120, 0.04, 100, 3);
+  LayoutState* s = layout_resume(&g, path);
+  ASSERT_EQ(20, s->iter);
+  s->params.max_iter = 30;
+  layout_save(s, path, false);
+  layout_free(s);
+  ASSERT_EQ(0, spring_layout_checkpointed(&g, &p, path, 10, true, true));
+  for (int i = 0; i < g.n; i++)
+    ASSERT_EQ(full.x[i], g.x[i]);
+  free_graph(g);
+  free_graph(full);
+  remove(path);
+}
+
+// Writer publishing frames with all coordinates equal to the frame number
+typedef struct FrameWriter {
+  Graph* g;
+  LayoutFrames* f;
+  int nb_frames;
+} FrameWriter;
+
+static void* write_frames(void* arg)
+{
+  FrameWriter* w = arg;
+  for (int k = 1; k <= w->nb_frames; k++) {
+    for (int i = 0; i < w->g->n; i++)
+      w->g->x[i] = w->g->y[i] = k;
+    publish_layout_frame(w->f, w->g, NULL);
+  }
+  return NULL;
+}
+
+UTEST(spring_embed, frames) {
+  Graph g = make_random_graph(2000, 0.0, 100, 1);
+  for (int i = 0; i < g.n; i++)
+    g.x[i] = g.y[i] = 0.0;
+  LayoutFrames* f = new_layout_frames(&g);
+  FrameWriter w = {&g, f, 3000};
+  pthread_t t;
+  pthread_create(&t, NULL, write_frames, &w);
+  double* out = malloc(2 * g.n * sizeof(double));
+  uint64_t last = 0;
+  int torn = 0;
+  while (last < (uint64_t)w.nb_frames) {
+    uint64_t e = read_layout_frame(f, out);
+    ASSERT_GE(e, last);
+    for (int i = 0; i < 2 * g.n; i++)
+      torn += (out[i] != (double)e);
+    last = e;
+  }
+  pthread_join(t, NULL);
+  ASSERT_EQ(0, torn);
+  // Frames follow the caller's numbering during a reordered layout
+  LayoutParams p = {5, 2, 0.01, -1.0, -1.0, 2};
+  Graph h = make_random_graph(200, 0.03, 100, 4);
+  LayoutState* s = layout_init(&h, &p);
+  LayoutFrames* hf = new_layout_frames(&h);
+  s->frames = hf;
+  while (layout_step(s));
+  layout_free(s);
+  double* pos = malloc(2 * h.n * sizeof(double));
+  ASSERT_EQ(5u, read_layout_frame(hf, pos));
+  for (int i = 0; i < h.n; i++) {
+    ASSERT_EQ(h.x[i], pos[2*i]);
+    ASSERT_EQ(h.y[i], pos[2*i + 1]);
+  }
+  free(pos);
+  free_layout_frames(hf);
+  free_graph(h);
+  free(out);
+  free_layout_frames(f);
+  free_graph(g);
+}
+
+// Viewer reading frames until stopped
+typedef struct FrameReader {
+  LayoutFrames* f;
+  int n;
+  atomic_bool stop;
+  uint64_t last;
+} FrameReader;
+
+static void* read_frames(void* arg)
+{
+  FrameReader* r = arg;
+  double* out = malloc(2 * r->n * sizeof(double));
+  while (!atomic_load(&r->stop))
+    r->last = read_layout_frame(r->f, out);
+  r->last = read_layout_frame(r->f, out);
+  free(out);
+  return NULL;
+}
+
+UTEST(spring_embed, frames_outlive_state) {
+  // A viewer reads while the layout steps, then while it is freed
+  LayoutParams p = {20, 2, 0.01, -1.0, -1.0, 3};
+  Graph g = make_random_graph(300, 0.02, 100, 6);
+  LayoutState* s = layout_init(&g, &p);
+  FrameReader r = {.f = new_layout_frames(&g), .n = g.n, .last = 0};
+  atomic_init(&r.stop, false);
+  s->frames = r.f;
+  pthread_t t;
+  pthread_create(&t, NULL, read_frames, &r);
+  while (layout_step(s));
+  layout_free(s);
+  atomic_store(&r.stop, true);
+  pthread_join(t, NULL);
+  ASSERT_EQ(20u, r.last);
+  free_layout_frames(r.f);
+  free_graph(g);
+}
+
+UTEST(spring_embed, set_params) {
+  // Same parameters again: same result as a single run
+  LayoutParams p = {30, 2, 0.01, -1.0, -1.0, 0};
+  Graph full = make_random_graph(150, 0.03, 100, 8);
+  spring_layout(&full, 30, 2, 0.01, -1.0, -1.0, 0);
+  Graph g = make_random_graph(150, 0.03, 100, 8);
+  LayoutState* s = layout_init(&g, &p);
+  for (int i = 0; i < 12; i++)
+    layout_step(s);
+  layout_set_params(s, &p);
+  while (layout_step(s));
+  ASSERT_EQ(full.x[7], g.x[7]);
+  // Reordering switched on in the middle, then more iterations
+  p.reorder_period = 5;
+  p.max_iter = 50;
+  p.grav_strength = 0.05;
+  layout_set_params(s, &p);
+  ASSERT_TRUE(s->order != NULL);
+  while (layout_step(s));
+  ASSERT_EQ(50, s->iter);
+  layout_free(s);
+  ASSERT_EQ(full.color[7], g.color[7]);
+  free_graph(g);
+  free_graph(full);
+}
@@ -1,9 +1,38 @@
 """
 grem : interface Python pour les graphes C (avec RAII)
+
+Native functions release the GIL: graphs can be built and laid out from
+several threads. A graph used by spring_layout() or reorder_graph() must
+not be used meanwhile by another thread (RuntimeError is raised), nor be
+modified through its NumPy views.
 """
 
+import asyncio
+
+import numpy as np
+
 from . import _native
 
+def set_num_threads(k):
+    """
+    set_num_threads(k: int) -> None
+    Set the number of threads used by parallel routines (graph generation).
+    Results do not depend on it for a given seed.
+
+    Parameters
+    ----------
+    k : int
+        Number of threads; <= 0 for one per available core (default).
+    """
+    _native.set_num_threads(k)
+
+def get_num_threads():
+    """
+    get_num_threads() -> int
+    Number of threads used by parallel routines.
+    """
+    return _native.get_num_threads()
+
 def make_random_graph(n, p, width, seed = -1):
     """
     make_random_graph(n: int, p: float, width: float, seed: int = -1) -> Graph
@@ -50,6 +79,29 @@ def make_random_tree(n, mode, width, seed = -1):
     """
     return _native.make_random_tree(n, mode, width, seed)
 
+def make_random_pa_graph(n, m, width, seed = -1):
+    """
+    make_random_pa_graph(n: int, m: int, width: float, seed: int = -1) -> Graph
+    Build a random Barabasi-Albert graph (preferential attachment).
+
+    Parameters
+    ----------
+    n : int
+        Number of nodes.
+    m : int
+        Number of edges from each new node to existing ones.
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The generated graph object.
+    """
+    return _native.make_random_pa_graph(n, m, width, seed)
+
 def make_random_binary_tree(n, width, seed = -1):
     """
     make_random_binary_tree(n: int, width: float, seed: int = -1) -> Graph
@@ -71,6 +123,28 @@ def make_random_binary_tree(n, width, seed = -1):
     """
     return _native.make_random_binary_tree(n, width, seed)
 
+def make_remy_binary_tree(n, width, seed = -1):
+    """
+    make_remy_binary_tree(n: int, width: float, seed: int = -1) -> Graph
+    Build a random (uniform) binary tree with Remy's algorithm, in O(n).
+    Node colors give the arrival step of each node.
+
+    Parameters
+    ----------
+    n : int
+        Number of nodes (rounded up to an odd number).
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The generated graph object.
+    """
+    return _native.make_remy_binary_tree(n, width, seed)
+
 def make_random_nary_tree(n, alpha, width, seed = -1):
     """
     make_random_nary_tree(n: int, alpha: float, width: float, seed: int = -1) -> Graph
@@ -94,6 +168,349 @@ def make_random_nary_tree(n, alpha, width, seed = -1):
     """
     return _native.make_random_nary_tree(n, alpha, width, seed)
 
+def make_random_sbm_graph(sizes, probs, width, seed = -1):
+    """
+    make_random_sbm_graph(sizes: List[int], probs: List[List[float]], width: float, seed: int = -1) -> Graph
+    Build a random graph from a stochastic block model, in O(n + m).
+    Nodes are numbered group after group.
+
+    Parameters
+    ----------
+    sizes : List[int]
+        Number of nodes in each of the k groups.
+    probs : List[List[float]]
+        Symmetric k x k matrix: probs[a][b] is the probability of an edge
+        between a node of group a and a node of group b.
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The generated graph object.
+    """
+    return _native.make_random_sbm_graph(sizes, probs, width, seed)
+
+def make_random_chung_lu_graph(weights, width, seed = -1):
+    """
+    make_random_chung_lu_graph(weights: List[float], width: float, seed: int = -1) -> Graph
+    Build a random graph with given expected degrees (Chung-Lu model),
+    in O(n + m). Self-loops and multiple edges are removed, so actual
+    degrees are slightly lower for heavy nodes.
+
+    Parameters
+    ----------
+    weights : List[float]
+        Expected degree of each node.
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The generated graph object.
+    """
+    return _native.make_random_chung_lu_graph(weights, width, seed)
+
+def make_random_geometric_graph(n, r, width, seed = -1):
+    """
+    make_random_geometric_graph(n: int, r: float, width: float, seed: int = -1) -> Graph
+    Build a random geometric graph: random points linked when at
+    distance at most r, in O(n + m).
+
+    Parameters
+    ----------
+    n : int
+        Number of nodes.
+    r : float
+        Connection radius.
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The generated graph object.
+    """
+    return _native.make_random_geometric_graph(n, r, width, seed)
+
+def make_grid_graph(rows, cols, width, seed = -1):
+    """
+    make_grid_graph(rows: int, cols: int, width: float, seed: int = -1) -> Graph
+    Build a rows x cols grid graph.
+    Node (i, j) has index i * cols + j; nodes start at random positions.
+
+    Parameters
+    ----------
+    rows : int
+        Number of rows.
+    cols : int
+        Number of columns.
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The generated graph object.
+    """
+    return _native.make_grid_graph(rows, cols, width, seed)
+
+def make_triangular_mesh(rows, cols, width, seed = -1):
+    """
+    make_triangular_mesh(rows: int, cols: int, width: float, seed: int = -1) -> Graph
+    Build a rows x cols grid with one diagonal per square (triangles).
+    Node (i, j) has index i * cols + j; nodes start at random positions.
+
+    Parameters
+    ----------
+    rows : int
+        Number of rows.
+    cols : int
+        Number of columns.
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The generated graph object.
+    """
+    return _native.make_triangular_mesh(rows, cols, width, seed)
+
+def make_torus_graph(rows, cols, width, seed = -1):
+    """
+    make_torus_graph(rows: int, cols: int, width: float, seed: int = -1) -> Graph
+    Build a rows x cols grid with wrap-around edges (torus).
+    Node (i, j) has index i * cols + j; nodes start at random positions.
+
+    Parameters
+    ----------
+    rows : int
+        Number of rows.
+    cols : int
+        Number of columns.
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The generated graph object.
+    """
+    return _native.make_torus_graph(rows, cols, width, seed)
+
+def read_graph(path):
+    """
+    read_graph(path: str) -> Graph
+    Load a graph in grem text format ("n m" line, n lines "x y color",
+    m lines "u v").
+
+    Parameters
+    ----------
+    path : str
+        Input file ("-" for standard input).
+
+    Returns
+    -------
+    Graph
+        The loaded graph object.
+    """
+    return _native.read_graph(path)
+
+def write_graph(g, path, exact = False):
+    """
+    write_graph(g: Graph, path: str, exact: bool = False) -> None
+    Save a graph in grem text format (positions with 6 decimals).
+
+    Parameters
+    ----------
+    g : Graph
+        Graph object.
+    path : str
+        Output file ("-" for standard output).
+    exact : bool
+        Write positions with all the digits needed to read them back
+        exactly.
+    """
+    _native.write_graph(g, path, exact)
+
+def read_edge_list(path, width, seed = -1, return_ids = False):
+    """
+    read_edge_list(path: str, width: float, seed: int = -1, return_ids: bool = False) -> Graph
+    Load a graph from an edge list: one "u v" pair of integer ids per line
+    (further columns ignored, '#' or '%' start comment lines).
+    Ids are renumbered 0..n-1 by order of first appearance. Nodes start at
+    random positions; self-loops and multiple edges are dropped.
+
+    Parameters
+    ----------
+    path : str
+        Input file ("-" for standard input).
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+    return_ids : bool
+        Also return the list of original ids, indexed by node.
+
+    Returns
+    -------
+    Graph or (Graph, List[int])
+        The loaded graph object (and original ids).
+    """
+    return _native.read_edge_list(path, width, seed, return_ids)
+
+def read_matrix_market(path, width, seed = -1):
+    """
+    read_matrix_market(path: str, width: float, seed: int = -1) -> Graph
+    Load a graph from a Matrix Market coordinate file (square matrix,
+    values ignored).
+    Nodes start at random positions; self-loops and multiple edges are
+    dropped.
+
+    Parameters
+    ----------
+    path : str
+        Input file ("-" for standard input).
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The loaded graph object.
+    """
+    return _native.read_matrix_market(path, width, seed)
+
+def read_metis(path, width, seed = -1):
+    """
+    read_metis(path: str, width: float, seed: int = -1) -> Graph
+    Load a graph from a METIS file (sizes and weights ignored).
+    Nodes start at random positions; self-loops and multiple edges are
+    dropped.
+
+    Parameters
+    ----------
+    path : str
+        Input file ("-" for standard input).
+    width : float
+        Width of the square area.
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The loaded graph object.
+    """
+    return _native.read_metis(path, width, seed)
+
+def write_graph_binary(g, path):
+    """
+    write_graph_binary(g: Graph, path: str) -> None
+    Save a graph in the binary format (lossless positions).
+
+    Parameters
+    ----------
+    g : Graph
+        Graph object.
+    path : str
+        Output file.
+    """
+    _native.write_graph_binary(g, path)
+
+def read_graph_binary(path, mmap = False):
+    """
+    read_graph_binary(path: str, mmap: bool = False) -> Graph
+    Load a graph saved by write_graph_binary.
+
+    Parameters
+    ----------
+    path : str
+        Input file.
+    mmap : bool
+        If True, map the file instead of copying it: pages are shared
+        with the page cache, and the file is never modified. The file is
+        checked as fully as a copy, which reads it once.
+
+    Returns
+    -------
+    Graph
+        The loaded graph object.
+    """
+    return _native.read_graph_binary(path, mmap)
+
+def write_graph_compressed(g, path, max_error = 0.0):
+    """
+    write_graph_compressed(g: Graph, path: str, max_error: float = 0.0) -> None
+    Save a graph in the compressed format (delta-encoded adjacency).
+    Reordering nodes first (reorder_graph) gives smaller files.
+
+    Parameters
+    ----------
+    g : Graph
+        Graph object.
+    path : str
+        Output file.
+    max_error : float
+        Maximum error on coordinates; positions are stored exactly if 0.
+    """
+    _native.write_graph_compressed(g, path, max_error)
+
+def read_graph_compressed(path):
+    """
+    read_graph_compressed(path: str) -> Graph
+    Load a graph saved by write_graph_compressed (neighbors come back
+    sorted).
+
+    Parameters
+    ----------
+    path : str
+        Input file.
+
+    Returns
+    -------
+    Graph
+        The loaded graph object.
+    """
+    return _native.read_graph_compressed(path)
+
+def reorder_graph(g, mode = 0):
+    """
+    reorder_graph(g: Graph, mode: int = 0) -> List[int]
+    Renumber nodes to improve memory locality of layout and traversals.
+
+    Parameters
+    ----------
+    g : Graph
+        Graph object, modified in place.
+    mode : int
+        0 for reverse Cuthill-McKee, 1 for BFS order,
+        2 for Hilbert curve order of current positions.
+
+    Returns
+    -------
+    List[int]
+        The permutation perm: new node i was node perm[i] before.
+        Colors move with their nodes.
+    """
+    return _native.reorder_graph(g, mode)
+
 def spring_layout(
     g,
     max_iter,
@@ -101,10 +518,17 @@ def spring_layout(
     grav_strength = 0.01,
     node_edge_repulsion = -1.0,
     node_edge_cutoff_factor = -1.0,
+    reorder_period = 0,
+    checkpoint = None,
+    checkpoint_period = 100,
+    store_distances = True,
+    resume = False,
 ):
     """
     spring_layout(g: Graph, max_iter: int, d: int, grav_strength: float,
-                  node_edge_repulsion: float, node_edge_cutoff_factor: float) -> None
+                  node_edge_repulsion: float, node_edge_cutoff_factor: float,
+                  reorder_period: int, checkpoint: str, checkpoint_period: int,
+                  store_distances: bool, resume: bool) -> None
     Rearrange the positions of nodes in the graph based on attractive and
     repulsive forces applied on nodes through edges.
 
@@ -124,6 +548,23 @@ def spring_layout(
     node_edge_cutoff_factor : float
         Anti-crossing interaction range as a factor of k.
         Set < 0 for internal default.
+    reorder_period : int
+        If > 0, renumber nodes internally by spatial position every
+        reorder_period iterations (faster on large graphs).
+        Node numbering is unchanged on return. Default to 0 (never).
+        To run a few iterations at a time, see LayoutSession.
+    checkpoint : str
+        If set, path of a binary file receiving the whole layout state
+        every checkpoint_period iterations and at the end. Default to None.
+    checkpoint_period : int
+        Iterations between two checkpoints. Default to 100
+    store_distances : bool
+        Also save graph distances (1 to 4 bytes per pair), so that resuming
+        skips their computation. Default to True
+    resume : bool
+        Continue from checkpoint if the file exists: parameters come from
+        the file, and the result is identical to an uninterrupted run.
+        The graph must be the same as when saved. Default to False
 
     Returns
     -------
@@ -136,13 +577,160 @@ def spring_layout(
         grav_strength,
         node_edge_repulsion,
         node_edge_cutoff_factor,
+        reorder_period,
+        "" if checkpoint is None else str(checkpoint),
+        checkpoint_period,
+        store_distances,
+        resume,
     )
 
+def graph_from_edges(edges, n = None, positions = None, width = 1.0, seed = -1):
+    """
+    graph_from_edges(edges: ndarray, n: int = None, positions: ndarray = None,
+                     width: float = 1.0, seed: int = -1) -> Graph
+    Build a graph from an array of undirected edges, in one native pass
+    (without the GIL). Edges are kept as given: loops and multiple edges
+    included. Also available as Graph.from_edges.
+
+    Parameters
+    ----------
+    edges : ndarray or SciPy sparse matrix
+        m x 2 array of node indices (converted to int32 if needed).
+        A sparse matrix is read as a symmetric adjacency matrix: its
+        entries (i, j) with i < j give the edges.
+    n : int
+        Number of nodes. Default to the largest index + 1 (or the sparse
+        matrix size).
+    positions : ndarray
+        n x 2 array of node positions. Random in [0, width]^2 if None.
+    width : float
+        Width of the square area for random positions. Default to 1.0
+    seed : int
+        Random if unspecified or < 0.
+
+    Returns
+    -------
+    Graph
+        The new graph object.
+    """
+    if hasattr(edges, "tocoo"):
+        coo = edges.tocoo()
+        upper = coo.row < coo.col
+        if n is None:
+            n = coo.shape[0]
+        edges = np.stack((coo.row[upper], coo.col[upper]), axis=1)
+    edges = np.asarray(edges)
+    if edges.size == 0:
+        edges = edges.reshape(0, 2)
+    if n is None:
+        n = int(edges.max()) + 1 if edges.size > 0 else 0
+    return _native.graph_from_edges(edges, n, positions, width, seed)
+
+def graph_from_csr(indptr, indices = None, positions = None, width = 1.0,
+                   seed = -1, copy = False):
+    """
+    graph_from_csr(indptr: ndarray, indices: ndarray, positions: ndarray = None,
+                   width: float = 1.0, seed: int = -1, copy: bool = False) -> Graph
+    Build a graph from a compressed sparse row structure: the neighbors of
+    node i are indices[indptr[i]:indptr[i+1]], each edge being listed at
+    both ends. Also available as Graph.from_csr.
+    An int32 contiguous writable indices array is adopted without copy
+    (unless copy): the graph keeps it alive and uses it as adjacency, so
+    it must not be modified meanwhile, and reorder_graph() rewrites it.
+
+    Parameters
+    ----------
+    indptr : ndarray or SciPy sparse matrix
+        n + 1 row offsets, or a symmetric sparse adjacency matrix (its
+        CSR arrays are then used, indices being ignored).
+    indices : ndarray
+        Column indices (neighbors).
+    positions : ndarray
+        n x 2 array of node positions. Random in [0, width]^2 if None.
+    width : float
+        Width of the square area for random positions. Default to 1.0
+    seed : int
+        Random if unspecified or < 0.
+    copy : bool
+        Always copy indices into the graph. Default to False
+
+    Returns
+    -------
+    Graph
+        The new graph object.
+    """
+    if hasattr(indptr, "tocsr"):
+        csr = indptr.tocsr()
+        indptr, indices = csr.indptr, csr.indices
+    if indices is None:
+        raise ValueError("indices is required with an indptr array")
+    return _native.graph_from_csr(indptr, indices, positions, width, seed, copy)
+
+def spring_layout_async(
+    g,
+    max_iter,
+    d = 2,
+    grav_strength = 0.01,
+    node_edge_repulsion = -1.0,
+    node_edge_cutoff_factor = -1.0,
+    reorder_period = 0,
+):
+    """
+    spring_layout_async(g: Graph, max_iter: int, ...) -> LayoutJob
+    Run spring_layout() on a native worker thread, and return at once.
+    Arguments are the same as for spring_layout() (without checkpoints).
+
+    The returned job can be polled or awaited (asyncio):
+      - done(), wait(timeout=None): completion;
+      - progress(): (iterations done, largest move at last iteration),
+        read without locks;
+      - positions(): copy of the positions after the last complete
+        iteration (n x 2 array), e.g. to show a layout being refined;
+        never torn, and taken without slowing the layout down;
+      - frame(): (number, positions), number being the iterations done
+        when these positions were published (to skip unchanged frames);
+      - cancel(): stop after the current iteration (positions are those
+        of the last complete iteration);
+      - add_done_callback(fn): fn(job) called on completion, from the
+        worker thread.
+    The graph cannot be laid out or reordered by others meanwhile.
+
+    Returns
+    -------
+    LayoutJob
+        Handle on the running layout.
+    """
+    return _native.spring_layout_async(
+        g,
+        max_iter,
+        d,
+        grav_strength,
+        node_edge_repulsion,
+        node_edge_cutoff_factor,
+        reorder_period,
+    )
+
+def _await_layout_job(job):
+    # Resolved from the worker thread through the event loop
+    loop = asyncio.get_running_loop()
+    fut = loop.create_future()
+    def wake(_job):
+        loop.call_soon_threadsafe(lambda: fut.done() or fut.set_result(None))
+    job.add_done_callback(wake)
+    yield from fut
+    return job
+
 from ._native import (
     Graph,
+    LayoutJob,
+    LayoutSession,
     Node,
 )
 
+Graph.from_edges = staticmethod(graph_from_edges)
+Graph.from_csr = staticmethod(graph_from_csr)
+LayoutJob.__await__ = _await_layout_job
+
 from .viz import (
     plot_graph,
     animate_graph,
@@ -151,11 +739,36 @@ from .viz import (
 __all__ = [
     "Graph",
     "Node",
+    "set_num_threads",
+    "get_num_threads",
     "make_random_graph",
     "make_random_tree",
+    "make_random_pa_graph",
     "make_random_binary_tree",
+    "make_remy_binary_tree",
     "make_random_nary_tree",
+    "make_random_sbm_graph",
+    "make_random_chung_lu_graph",
+    "make_random_geometric_graph",
+    "make_grid_graph",
+    "make_triangular_mesh",
+    "make_torus_graph",
+    "read_graph",
+    "write_graph",
+    "read_edge_list",
+    "read_matrix_market",
+    "read_metis",
+    "write_graph_binary",
+    "read_graph_binary",
+    "write_graph_compressed",
+    "read_graph_compressed",
+    "graph_from_edges",
+    "graph_from_csr",
+    "reorder_graph",
     "spring_layout",
+    "spring_layout_async",
+    "LayoutJob",
+    "LayoutSession",
     "plot_graph",
     "animate_graph",
 ]
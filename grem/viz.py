@@ -22,14 +22,11 @@ def _load_graph_data(*, g=None, path=None):
         arrival = [c[2] for c in cc]
         edges = [tuple(map(int, lines[n + 1 + j].split())) for j in range(m)]
     else:
-        n = len(g.nodes)
-        coords = [(nd["x"], nd["y"]) for nd in g.nodes]
-        arrival = [nd["color"] for nd in g.nodes]
-        edges = []
-        for i, nd in enumerate(g.nodes):
-            for j in nd["neighbors"]:
-                if i < j:
-                    edges.append((i, j))
+        # Native views and edge array: no per-node Python objects
+        n = g.n
+        coords = g.positions.tolist()
+        arrival = g.colors.tolist()
+        edges = g.edges.tolist()
 
     return n, coords, arrival, edges
 
@@ -1,12 +1,31 @@
 // python/wrapper.cpp
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include <memory>   // pour std::shared_ptr
+#include <optional>
 #include <vector>
+#include <string>
+#include <stdexcept>
+#include <climits>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <unistd.h> // getpid
 
 extern "C" {
   #include "../c_project/src/graph.h"
   #include "../c_project/src/graph_dist.h"
+  #include "../c_project/src/graph_io.h"
+  #include "../c_project/src/graph_models.h"
+  #include "../c_project/src/graph_order.h"
+  #include "../c_project/src/parallel.h"
   #include "../c_project/src/spring_embed.h"
 }
 
@@ -16,34 +35,46 @@ namespace py = pybind11;
 // Utilitaires de conversion
 /////////////////////////////
 
-static std::vector<int> node_neighbors(const Node& node) {
+static std::vector<int> node_neighbors(const Graph& g, int i) {
   std::vector<int> neigh;
-  if (node.degree <= 0) return neigh;
-  if (node.neighbors == nullptr)
+  if (g.degree[i] <= 0) return neigh;
+  if (g.neighbors[i] == nullptr)
     throw std::runtime_error("node.neighbors is null despite degree > 0");
 
-  neigh.reserve(node.degree);
-  for (int i = 0; i < node.degree; ++i)
-    neigh.push_back(node.neighbors[i]);
+  neigh.reserve(g.degree[i]);
+  for (int j = 0; j < g.degree[i]; ++j)
+    neigh.push_back(g.neighbors[i][j]);
   return neigh;
 }
 
 static py::list graph_to_list(const Graph& g) {
   py::list L;
   for (int i = 0; i < g.n; ++i) {
-    const Node& nd = g.nodes[i];
     py::dict d;
-    d["id"] = nd.id;
-    d["x"] = nd.x;
-    d["y"] = nd.y;
-    d["color"] = nd.color;
-    d["degree"] = nd.degree;
-    d["neighbors"] = node_neighbors(nd);
+    d["id"] = i;
+    d["x"] = g.x[i];
+    d["y"] = g.y[i];
+    d["color"] = g.color[i];
+    d["degree"] = g.degree[i];
+    d["neighbors"] = node_neighbors(g, i);
     L.append(d);
   }
   return L;
 }
 
+// NumPy array over graph memory: owner (the Python Graph) stays alive as
+// long as the array does
+template <typename T>
+static py::array_t<T> graph_array(py::handle owner, T* data,
+                                  std::vector<py::ssize_t> shape,
+                                  std::vector<py::ssize_t> strides,
+                                  bool writeable) {
+  py::array_t<T> a(shape, strides, data, owner);
+  if (!writeable)
+    a.attr("flags").attr("writeable") = false;
+  return a;
+}
+
 /////////////////////////////
 // RAII Memory Management
 /////////////////////////////
@@ -51,8 +82,21 @@ static py::list graph_to_list(const Graph& g) {
 // A "deleter" for std::shared_ptr<Graph> which call free_graph()
 struct GraphDeleter {
   void operator()(Graph* g) const noexcept {
-    if (g)
+    if (g) {
       free_graph(*g);
+      free(g);
+    }
+  }
+};
+
+// Graph using memory owned by Python objects (adopted arrays): they stay
+// alive with the graph, and are released with the GIL held
+struct AdoptingDeleter {
+  py::object owner;
+  void operator()(Graph* g) {
+    GraphDeleter()(g);
+    py::gil_scoped_acquire gil;
+    owner = py::object();
   }
 };
 
@@ -65,6 +109,252 @@ inline std::shared_ptr<Graph> make_graph(Graph g) {
   return std::shared_ptr<Graph>(heap_copy, GraphDeleter());
 }
 
+inline std::shared_ptr<Graph> make_adopting_graph(Graph g, py::object owner) {
+  Graph* heap_copy = (Graph*)malloc(sizeof(Graph));
+  *heap_copy = g;
+  return std::shared_ptr<Graph>(heap_copy, AdoptingDeleter{owner});
+}
+
+// Graph from a failing reader or constructor (n = -1)
+inline void check_graph(Graph& g) {
+  if (g.n < 0) {
+    free_graph(g);
+    throw std::runtime_error(graph_error());
+  }
+}
+
+// Node data lives in the graph arrays: a Node is a view (graph, index)
+// which keeps its graph alive.
+struct NodeView {
+  std::shared_ptr<Graph> g;
+  int i;
+};
+
+/////////////////////////////
+// Concurrent use
+/////////////////////////////
+
+// Native calls run without the GIL, so several Python threads may reach
+// the same graph: readers (writers to files, edges...) can share it, a
+// writer (layout, reordering) needs it alone. A conflicting call fails
+// at once instead of waiting or corrupting memory.
+static std::mutex busy_mutex;
+static std::unordered_map<const Graph*, int> busy; //readers count, -1: writer
+
+class GraphUse {
+public:
+  GraphUse(const Graph* g, bool write) : g_(g), write_(write) {
+    std::lock_guard<std::mutex> lock(busy_mutex);
+    int& state = busy[g];
+    if (state < 0 || (write && state > 0))
+      throw std::runtime_error("graph is in use by another thread");
+    state = (write ? -1 : state + 1);
+  }
+  ~GraphUse() {
+    std::lock_guard<std::mutex> lock(busy_mutex);
+    auto it = busy.find(g_);
+    if (write_ || it->second == 1)
+      busy.erase(it);
+    else
+      it->second--;
+  }
+  GraphUse(const GraphUse&) = delete;
+  GraphUse& operator=(const GraphUse&) = delete;
+private:
+  const Graph* g_;
+  bool write_;
+};
+
+using nogil = py::call_guard<py::gil_scoped_release>;
+
+/////////////////////////////
+// Asynchronous layouts
+/////////////////////////////
+
+// Set by an atexit hook: running layouts stop, callbacks are skipped and
+// no job is accepted anymore
+static std::atomic<bool> exiting{false};
+
+// Worker threads running jobs in submission order, started on first use.
+// Never destroyed: drain() (at exit) only waits for them to be idle.
+class WorkerPool {
+public:
+  static WorkerPool& get() {
+    WorkerPool*& pool = instance();
+    if (pool == nullptr)
+      pool = new WorkerPool(get_num_threads());
+    return *pool;
+  }
+  // Wait for queued and running jobs, if the pool was ever started
+  static void drain() {
+    WorkerPool* pool = instance();
+    if (pool == nullptr)
+      return;
+    std::unique_lock<std::mutex> lock(pool->mutex_);
+    pool->idle_cv_.wait(lock, [pool]{
+      return pool->tasks_.empty() && pool->running_ == 0;
+    });
+  }
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (exiting)
+        throw std::runtime_error("interpreter is shutting down");
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+private:
+  static WorkerPool*& instance() { //accessed with the GIL held
+    static WorkerPool* pool = nullptr;
+    return pool;
+  }
+  explicit WorkerPool(int k) {
+    for (int i = 0; i < k; i++)
+      std::thread([this]{ run(); }).detach();
+  }
+  void run() {
+    for (;;) {
+      {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          cv_.wait(lock, [this]{ return !tasks_.empty(); });
+          task = std::move(tasks_.front());
+          tasks_.pop_front();
+          running_++;
+        }
+        task();
+      } //task released (job and graph with it) before counting it done
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--running_ == 0 && tasks_.empty())
+        idle_cv_.notify_all();
+    }
+  }
+  std::mutex mutex_;
+  std::condition_variable cv_, idle_cv_;
+  std::deque<std::function<void()>> tasks_;
+  int running_ = 0;
+};
+
+// A spring layout running on the pool. Progress counters are atomics and
+// positions are published as frames after each iteration: both are read
+// without locks, and never slow the layout down.
+struct LayoutJob : std::enable_shared_from_this<LayoutJob> {
+  std::shared_ptr<Graph> g;
+  std::unique_ptr<GraphUse> use; //graph held until the end
+  LayoutParams params;
+  std::atomic<int> iter{0};
+  std::atomic<double> max_delta{0.0};
+  std::atomic<bool> cancel{false}, done{false};
+  LayoutFrames* frames = nullptr;
+  std::mutex mutex; //callbacks, done_cv
+  std::condition_variable done_cv;
+  std::vector<py::object> callbacks;
+
+  ~LayoutJob() { free_layout_frames(frames); }
+
+  void run() {
+    LayoutState* s = (cancel || exiting ? nullptr : layout_init(g.get(), &params));
+    if (s != nullptr) {
+      s->frames = frames;
+      while (!cancel && !exiting && layout_step(s)) {
+        max_delta.store(s->max_delta);
+        iter.store(s->iter);
+      }
+      layout_free(s);
+    }
+    use.reset();
+    std::vector<py::object> todo;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+      todo.swap(callbacks);
+    }
+    done_cv.notify_all();
+    if (!todo.empty())
+      run_callbacks(todo);
+  }
+
+  void run_callbacks(std::vector<py::object>& todo) {
+    if (exiting || !Py_IsInitialized()) {
+      // The interpreter may be gone: never take the GIL, leak callbacks
+      for (auto& f : todo)
+        f.release();
+      todo.clear();
+      return;
+    }
+    py::gil_scoped_acquire gil;
+    py::object self = py::cast(shared_from_this());
+    for (auto& f : todo) {
+      try {
+        f(self);
+      } catch (py::error_already_set& e) {
+        e.discard_as_unraisable("LayoutJob callback");
+      }
+    }
+    todo.clear();
+  }
+};
+
+// Stepwise layout owning its state (distances, temperature, quadtree
+// arena...): each step only runs iterations. The graph is held, and
+// renumbered if reordering, until close().
+// The state is only touched under busy; other threads (viewers) read
+// frames and counters published after each step, without locks. Frames
+// live as long as the session, so reading them races with nothing.
+struct LayoutSession {
+  std::shared_ptr<Graph> g;
+  std::unique_ptr<GraphUse> use;
+  LayoutState* s = nullptr; //under busy
+  LayoutFrames* frames = nullptr;
+  std::mutex busy; //steps, changes and close
+  std::atomic<bool> closed{false}, converged{false};
+  std::atomic<int> iter{0};
+  std::atomic<double> max_delta{0.0}, temperature{0.0};
+
+  ~LayoutSession() {
+    close();
+    free_layout_frames(frames);
+  }
+
+  // Lock for a step or a change; fails if a step runs in another thread
+  std::unique_lock<std::mutex> exclusive() {
+    std::unique_lock<std::mutex> lock(busy, std::try_to_lock);
+    if (!lock.owns_lock())
+      throw std::runtime_error("layout session is stepping in another thread");
+    return lock;
+  }
+  // With busy held
+  LayoutState* state() {
+    if (s == nullptr)
+      throw std::runtime_error("layout session is closed");
+    return s;
+  }
+  // Without lock: counters and frames stay readable after close(), but
+  // a closed session raises like for any other use
+  void check_open() const {
+    if (closed)
+      throw std::runtime_error("layout session is closed");
+  }
+  // With busy held, after any change of s
+  void publish() {
+    iter.store(s->iter);
+    max_delta.store(s->max_delta);
+    converged.store(s->converged);
+    temperature.store(s->t);
+  }
+  void close() {
+    std::lock_guard<std::mutex> lock(busy);
+    if (s != nullptr) {
+      layout_free(s);
+      s = nullptr;
+    }
+    closed = true;
+    use.reset();
+  }
+};
+
 /////////////////////////////
 // Pybind11 Module
 /////////////////////////////
@@ -72,10 +362,18 @@ inline std::shared_ptr<Graph> make_graph(Graph g) {
 PYBIND11_MODULE(_native, m) {
   m.doc() = "Python interface to grem C methods, with automatic memory management (RAII).";
 
+  // Stop asynchronous layouts before finalization, while worker threads
+  // can still take the GIL (callbacks, graphs released)
+  py::module_::import("atexit").attr("register")(py::cpp_function([]{
+    exiting = true;
+    py::gil_scoped_release release;
+    WorkerPool::drain();
+  }));
+
   // -----------------
   // Struct Node
   // -----------------
-  py::class_<Node>(m,
+  py::class_<NodeView>(m,
     "Node",
     R"pbdoc(
     Node data structure.
@@ -103,15 +401,22 @@ PYBIND11_MODULE(_native, m) {
     neighbors : List[Node]
                 The list of neighbor nodes.
     )pbdoc")
-    .def_property_readonly("id", [](const Node& n){ return n.id; })
-    .def_readwrite("x", &Node::x)
-    .def_readwrite("y", &Node::y)
-    .def_property_readonly("color", [](const Node& n){ return n.color; })
-    .def_property_readonly("degree", [](const Node& n){ return n.degree; })
-    .def_property_readonly("neighbors", [](const Node& n){ return node_neighbors(n); })
-    .def("__repr__", [](const Node& n){
-      return "<Node id=" + std::to_string(n.id) +
-             " (" + std::to_string(n.x) + "," + std::to_string(n.y) + ")>";
+    .def_property_readonly("id", [](const NodeView& v){ return v.i; })
+    .def_property("x",
+      [](const NodeView& v){ return v.g->x[v.i]; },
+      [](NodeView& v, double x){ GraphUse use(v.g.get(), true); v.g->x[v.i] = x; })
+    .def_property("y",
+      [](const NodeView& v){ return v.g->y[v.i]; },
+      [](NodeView& v, double y){ GraphUse use(v.g.get(), true); v.g->y[v.i] = y; })
+    .def_property_readonly("color", [](const NodeView& v){ return v.g->color[v.i]; })
+    .def_property_readonly("degree", [](const NodeView& v){ return v.g->degree[v.i]; })
+    .def_property_readonly("neighbors", [](const NodeView& v){
+      GraphUse use(v.g.get(), false);
+      return node_neighbors(*v.g, v.i);
+    })
+    .def("__repr__", [](const NodeView& v){
+      return "<Node id=" + std::to_string(v.i) +
+             " (" + std::to_string(v.g->x[v.i]) + "," + std::to_string(v.g->y[v.i]) + ")>";
     });
 
   // -----------------
@@ -131,10 +436,162 @@ PYBIND11_MODULE(_native, m) {
         The number of nodes.
 
     nodes : List[Node]
-            The list of nodes in the graph.
+            The list of nodes in the graph (a copy, built at each access).
+
+    positions : numpy.ndarray
+                n x 2 float64 view of the node positions (writable,
+                no copy).
+
+    colors : numpy.ndarray
+             int32 view of the node colors (writable, no copy).
+
+    degrees : numpy.ndarray
+              int32 view of the node degrees (read-only, no copy).
+
+    edges : numpy.ndarray
+            m x 2 int32 array of edges (u, v) with u < v (a copy).
+
+    Threads
+    -------
+    Native functions release the GIL. A graph may be read by several
+    threads at once (writing files, edges, nodes), but spring_layout() and
+    reorder_graph() need it alone: a conflicting call raises RuntimeError
+    at once. The positions, colors and degrees arrays are not covered:
+    do not write to them (nor to arrays adopted by from_csr) while another
+    thread works on the graph.
+
+    Processes
+    ---------
+    Graphs pickle losslessly through the binary file format, which makes
+    multiprocessing transfers cheap. To share one graph with several
+    processes without copies, use name = g.to_shared_memory() and
+    Graph.attach(name) in each worker, then
+    Graph.unlink_shared_memory(name) once all workers attached.
     )pbdoc")
     .def_property_readonly("n", [](const Graph& g){ return g.n; })
-    .def_property_readonly("nodes", [](const Graph& g){ return graph_to_list(g); })
+    .def_property_readonly("nodes", [](const Graph& g){
+      GraphUse use(&g, false);
+      return graph_to_list(g);
+    })
+    // Views stay valid while the graph lives: layouts and reorderings
+    // work in place
+    .def_property_readonly("positions", [](py::object self){
+      Graph& g = self.cast<Graph&>();
+      return graph_array<double>(self, g.x, {g.n, 2},
+                                 {(py::ssize_t)sizeof(double),
+                                  (py::ssize_t)(g.capacity * sizeof(double))}, true);
+    })
+    .def_property_readonly("colors", [](py::object self){
+      Graph& g = self.cast<Graph&>();
+      return graph_array<int>(self, g.color, {g.n}, {(py::ssize_t)sizeof(int)}, true);
+    })
+    .def_property_readonly("degrees", [](py::object self){
+      Graph& g = self.cast<Graph&>();
+      return graph_array<int>(self, g.degree, {g.n}, {(py::ssize_t)sizeof(int)}, false);
+    })
+    .def_property_readonly("edges", [](const Graph& g){
+      long m;
+      int* edges;
+      {
+        GraphUse use(&g, false);
+        py::gil_scoped_release release;
+        edges = list_edges(&g, &m);
+      }
+      py::capsule owner(edges, [](void* p){ free(p); });
+      return graph_array<int>(owner, edges, {(py::ssize_t)m, 2},
+                              {(py::ssize_t)(2 * sizeof(int)), (py::ssize_t)sizeof(int)},
+                              true);
+    })
+    // Pickling: state is the binary file image (lossless), filled and
+    // parsed without the GIL
+    .def(py::pickle(
+      [](const Graph& g) {
+        GraphUse use(&g, false);
+        size_t len = graph_binary_size(&g);
+        PyObject* raw = PyBytes_FromStringAndSize(nullptr, (py::ssize_t)len);
+        if (raw == nullptr)
+          throw py::error_already_set();
+        auto state = py::reinterpret_steal<py::bytes>(raw);
+        char* buf = PyBytes_AS_STRING(raw);
+        {
+          py::gil_scoped_release release;
+          write_graph_binary_buffer(&g, buf, len);
+        }
+        return state;
+      },
+      [](const py::bytes& state) {
+        std::string_view buf = state;
+        Graph g;
+        {
+          py::gil_scoped_release release;
+          g = read_graph_binary_buffer(buf.data(), buf.size());
+        }
+        check_graph(g);
+        return make_graph(g);
+      }))
+    .def("to_shared_memory", [](const Graph& g, std::optional<std::string> name) {
+      static std::atomic<long> counter{0};
+      std::string id = name ? *name
+        : "/grem-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+      GraphUse use(&g, false);
+      py::gil_scoped_release release;
+      if (share_graph(&g, id.c_str()) != 0)
+        throw std::runtime_error(graph_error());
+      return id;
+    },
+    R"pbdoc(
+    Copy the graph into a new POSIX shared memory object.
+
+    Parameters
+    ----------
+    name : str, optional
+           Object name, like "/my-graph" (must not exist). By default a
+           unique name "/grem-<pid>-<k>" is generated.
+
+    Returns
+    -------
+    str
+        The name, to pass to Graph.attach() in other processes. The object
+        outlives this graph and the process: release it with
+        Graph.unlink_shared_memory(name).
+    )pbdoc",
+    py::arg("name") = py::none())
+    .def_static("attach", [](const std::string& name) {
+      Graph g = attach_graph(name.c_str());
+      check_graph(g);
+      return make_graph(g);
+    },
+    R"pbdoc(
+    Graph mapped from a shared memory object made by to_shared_memory().
+
+    Nothing is copied: pages are shared until written (positions during a
+    layout, for instance), and changes stay private to this graph. The
+    image is checked like an unpickled one: a corrupt or partial object
+    raises RuntimeError.
+
+    Parameters
+    ----------
+    name : str
+           Name returned by to_shared_memory().
+    )pbdoc",
+    py::arg("name"), nogil())
+    .def_static("unlink_shared_memory", [](const std::string& name) {
+      if (unlink_shared_graph(name.c_str()) != 0)
+        throw std::runtime_error(graph_error());
+    },
+    R"pbdoc(
+    Remove a shared memory object by name. Graphs already attached stay
+    valid; memory is freed once the last one is released.
+    )pbdoc",
+    py::arg("name"), nogil())
+    .def("__len__", [](const Graph& g){ return g.n; })
+    .def("__getitem__", [](std::shared_ptr<Graph> g, int i){
+      if (i < 0)
+        i += g->n;
+      if (i < 0 || i >= g->n)
+        throw py::index_error("node index out of range");
+      return NodeView{g, i};
+    })
     .def("__repr__", [](const Graph& g){
       return "<Graph n=" + std::to_string(g.n) + ">";
     });
@@ -143,45 +600,512 @@ PYBIND11_MODULE(_native, m) {
   // Exposed functions
   // -----------------
 
+  // Threads used by parallel routines
+  m.def("set_num_threads", &set_num_threads, py::arg("k"));
+  m.def("get_num_threads", &get_num_threads);
+
   // Génération de graphes
   m.def(
     "make_random_graph",
     [](int n, double p, double width, int seed) {
       return make_graph(make_random_graph(n, p, width, seed));
     },
-    py::arg("n"), py::arg("p"), py::arg("width"), py::arg("seed") = -1);
+    py::arg("n"), py::arg("p"), py::arg("width"), py::arg("seed") = -1, nogil());
 
   m.def(
     "make_random_tree",
     [](int n, int mode, double width, int seed) {
       return make_graph(make_random_tree(n, mode, width, seed));
     },
-    py::arg("n"), py::arg("mode"), py::arg("width"), py::arg("seed") = -1);
+    py::arg("n"), py::arg("mode"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  m.def(
+    "make_random_pa_graph",
+    [](int n, int m, double width, int seed) {
+      return make_graph(make_random_pa_graph(n, m, width, seed));
+    },
+    py::arg("n"), py::arg("m"), py::arg("width"), py::arg("seed") = -1, nogil());
 
   m.def(
     "make_random_binary_tree",
     [](int n, double width, int seed) {
       return make_graph(make_random_binary_tree(n, width, seed));
     },
-    py::arg("n"), py::arg("width"), py::arg("seed") = -1);
+    py::arg("n"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  m.def(
+    "make_remy_binary_tree",
+    [](int n, double width, int seed) {
+      return make_graph(make_remy_binary_tree(n, width, seed));
+    },
+    py::arg("n"), py::arg("width"), py::arg("seed") = -1, nogil());
 
   m.def(
     "make_random_nary_tree",
     [](int n, double alpha, double width, int seed) {
       return make_graph(make_random_nary_tree(n, alpha, width, seed));
     },
-    py::arg("n"), py::arg("alpha"), py::arg("width"), py::arg("seed") = -1);
+    py::arg("n"), py::arg("alpha"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  m.def(
+    "make_random_sbm_graph",
+    [](const std::vector<int>& sizes, const std::vector<std::vector<double>>& probs,
+       double width, int seed) {
+      int k = (int)sizes.size();
+      if ((int)probs.size() != k)
+        throw py::value_error("probs must be a k x k matrix");
+      std::vector<double> flat;
+      for (const auto& row : probs) {
+        if ((int)row.size() != k)
+          throw py::value_error("probs must be a k x k matrix");
+        flat.insert(flat.end(), row.begin(), row.end());
+      }
+      return make_graph(make_random_sbm_graph(k, sizes.data(), flat.data(), width, seed));
+    },
+    py::arg("sizes"), py::arg("probs"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  m.def(
+    "make_random_chung_lu_graph",
+    [](const std::vector<double>& weights, double width, int seed) {
+      return make_graph(make_random_chung_lu_graph(
+        (int)weights.size(), weights.data(), width, seed));
+    },
+    py::arg("weights"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  m.def(
+    "make_random_geometric_graph",
+    [](int n, double r, double width, int seed) {
+      return make_graph(make_random_geometric_graph(n, r, width, seed));
+    },
+    py::arg("n"), py::arg("r"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  m.def(
+    "make_grid_graph",
+    [](int rows, int cols, double width, int seed) {
+      return make_graph(make_grid_graph(rows, cols, width, seed));
+    },
+    py::arg("rows"), py::arg("cols"), py::arg("width"), py::arg("seed") = -1, nogil());
 
-  // TODO: read/write graph functions
+  m.def(
+    "make_triangular_mesh",
+    [](int rows, int cols, double width, int seed) {
+      return make_graph(make_triangular_mesh(rows, cols, width, seed));
+    },
+    py::arg("rows"), py::arg("cols"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  m.def(
+    "make_torus_graph",
+    [](int rows, int cols, double width, int seed) {
+      return make_graph(make_torus_graph(rows, cols, width, seed));
+    },
+    py::arg("rows"), py::arg("cols"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  // Text files
+  m.def(
+    "read_graph",
+    [](const std::string& path) {
+      Graph g = read_graph(const_cast<char*>(path.c_str()));
+      if (g.n < 0) {
+        free_graph(g);
+        throw std::runtime_error(graph_error());
+      }
+      return make_graph(g);
+    },
+    py::arg("path"), nogil());
+
+  m.def(
+    "write_graph",
+    [](std::shared_ptr<Graph> g, const std::string& path, bool exact) {
+      GraphUse use(g.get(), false);
+      char* p = const_cast<char*>(path.c_str());
+      if ((exact ? write_graph_exact(*g, p) : write_graph(*g, p)) != 0)
+        throw std::runtime_error(graph_error());
+    },
+    py::arg("graph"), py::arg("path"), py::arg("exact") = false, nogil());
+
+  m.def(
+    "read_edge_list",
+    [](const std::string& path, double width, int seed, bool return_ids) -> py::object {
+      long long* ids = nullptr;
+      Graph g;
+      {
+        py::gil_scoped_release release;
+        g = read_edge_list(const_cast<char*>(path.c_str()), width, seed,
+                           return_ids ? &ids : nullptr);
+      }
+      if (g.n < 0) {
+        free_graph(g);
+        throw std::runtime_error(graph_error());
+      }
+      auto graph = make_graph(g);
+      if (!return_ids)
+        return py::cast(graph);
+      std::vector<long long> res(ids, ids + graph->n);
+      free(ids);
+      return py::make_tuple(graph, res);
+    },
+    py::arg("path"), py::arg("width"), py::arg("seed") = -1,
+    py::arg("return_ids") = false);
+
+  m.def(
+    "read_matrix_market",
+    [](const std::string& path, double width, int seed) {
+      Graph g = read_matrix_market(const_cast<char*>(path.c_str()), width, seed);
+      if (g.n < 0) {
+        free_graph(g);
+        throw std::runtime_error(graph_error());
+      }
+      return make_graph(g);
+    },
+    py::arg("path"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  m.def(
+    "read_metis",
+    [](const std::string& path, double width, int seed) {
+      Graph g = read_metis(const_cast<char*>(path.c_str()), width, seed);
+      if (g.n < 0) {
+        free_graph(g);
+        throw std::runtime_error(graph_error());
+      }
+      return make_graph(g);
+    },
+    py::arg("path"), py::arg("width"), py::arg("seed") = -1, nogil());
+
+  // Binary graph files
+  m.def(
+    "write_graph_binary",
+    [](std::shared_ptr<Graph> g, const std::string& path) {
+      GraphUse use(g.get(), false);
+      if (write_graph_binary(g.get(), path.c_str()) != 0)
+        throw std::runtime_error(graph_error());
+    },
+    py::arg("graph"), py::arg("path"), nogil());
+
+  m.def(
+    "write_graph_compressed",
+    [](std::shared_ptr<Graph> g, const std::string& path, double max_error) {
+      GraphUse use(g.get(), false);
+      if (write_graph_compressed(g.get(), path.c_str(), max_error) != 0)
+        throw std::runtime_error(graph_error());
+    },
+    py::arg("graph"), py::arg("path"), py::arg("max_error") = 0.0, nogil());
+
+  m.def(
+    "read_graph_compressed",
+    [](const std::string& path) {
+      Graph g = read_graph_compressed(path.c_str());
+      if (g.n < 0) {
+        free_graph(g);
+        throw std::runtime_error(graph_error());
+      }
+      return make_graph(g);
+    },
+    py::arg("path"), nogil());
+
+  m.def(
+    "read_graph_binary",
+    [](const std::string& path, bool mmap) {
+      Graph g = mmap ? map_graph_binary(path.c_str())
+                     : read_graph_binary(path.c_str());
+      if (g.n < 0) {
+        free_graph(g);
+        throw std::runtime_error(graph_error());
+      }
+      return make_graph(g);
+    },
+    py::arg("path"), py::arg("mmap") = false, nogil());
+
+  // Graphs from NumPy arrays (converted only if dtype or layout differ)
+  using int_array = py::array_t<int, py::array::c_style | py::array::forcecast>;
+  using pos_array = py::array_t<double, py::array::c_style | py::array::forcecast>;
+  auto positions_ptr = [](const std::optional<pos_array>& pos, py::ssize_t n) {
+    if (!pos)
+      return (const double*)nullptr;
+    if (pos->ndim() != 2 || pos->shape(0) != n || pos->shape(1) != 2)
+      throw py::value_error("positions must have shape (n, 2)");
+    return pos->data();
+  };
+
+  m.def(
+    "graph_from_edges",
+    [positions_ptr](int_array edges, int n, std::optional<pos_array> positions,
+                    double width, int seed) {
+      if (edges.ndim() != 2 || edges.shape(1) != 2)
+        throw py::value_error("edges must have shape (m, 2)");
+      const double* pos = positions_ptr(positions, n);
+      Graph g;
+      {
+        py::gil_scoped_release release;
+        g = graph_from_edges(n, edges.data(), (long)edges.shape(0), pos, width, seed);
+      }
+      check_graph(g);
+      return make_graph(g);
+    },
+    py::arg("edges"), py::arg("n"), py::arg("positions") = py::none(),
+    py::arg("width") = 1.0, py::arg("seed") = -1);
+
+  m.def(
+    "graph_from_csr",
+    [positions_ptr](py::array_t<int64_t, py::array::c_style | py::array::forcecast> indptr,
+                    int_array indices, std::optional<pos_array> positions,
+                    double width, int seed, bool copy) {
+      if (indptr.ndim() != 1 || indptr.size() < 1 || indices.ndim() != 1)
+        throw py::value_error("indptr and indices must be 1-D, indptr not empty");
+      py::ssize_t n = indptr.size() - 1;
+      if (n > INT_MAX)
+        throw py::value_error("too many nodes");
+      if (indptr.data()[n] > indices.size())
+        throw py::value_error("indptr[-1] exceeds the length of indices");
+      const double* pos = positions_ptr(positions, n);
+      // Read-only arrays cannot be adopted (reordering rewrites them)
+      copy = copy || !indices.writeable();
+      Graph g;
+      {
+        py::gil_scoped_release release;
+        int* targets = const_cast<int*>(indices.data()); //written only if adopted
+        g = graph_from_csr((int)n, indptr.data(), targets, pos, width, seed, copy);
+      }
+      check_graph(g);
+      if (copy)
+        return make_graph(g);
+      return make_adopting_graph(g, indices);
+    },
+    py::arg("indptr"), py::arg("indices"), py::arg("positions") = py::none(),
+    py::arg("width") = 1.0, py::arg("seed") = -1, py::arg("copy") = false);
+
+  // Node reordering
+  m.def(
+    "reorder_graph",
+    [](std::shared_ptr<Graph> g, int mode) {
+      GraphUse use(g.get(), true);
+      int* perm = reorder_graph(g.get(), mode);
+      std::vector<int> res(perm, perm + g->n);
+      free(perm);
+      return res;
+    },
+    py::arg("graph"), py::arg("mode") = (int)ORDER_RCM, nogil());
+
+  // -----------------
+  // Asynchronous layout job
+  // -----------------
+  py::class_<LayoutJob, std::shared_ptr<LayoutJob>>(m,
+    "LayoutJob",
+    R"pbdoc(
+    Spring layout running on a native worker thread
+    (output of spring_layout_async()).
+
+    The graph is held by the job until it finishes: other layouts or
+    reorderings of it raise RuntimeError meanwhile. Awaitable.
+    At interpreter exit, jobs still running stop after their current
+    iteration, and their done callbacks are not called.
+    )pbdoc")
+    .def("done", [](const LayoutJob& j){ return j.done.load(); })
+    .def("cancel", [](LayoutJob& j){ j.cancel = true; })
+    .def("cancelled", [](const LayoutJob& j){ return j.cancel.load(); })
+    .def("progress", [](const LayoutJob& j){
+      return py::make_tuple(j.iter.load(), j.max_delta.load());
+    })
+    .def("wait", [](LayoutJob& j, std::optional<double> timeout){
+      py::gil_scoped_release release;
+      std::unique_lock<std::mutex> lock(j.mutex);
+      auto finished = [&j]{ return j.done.load(); };
+      if (!timeout)
+        j.done_cv.wait(lock, finished);
+      else
+        j.done_cv.wait_for(lock, std::chrono::duration<double>(*timeout), finished);
+      return j.done.load();
+    }, py::arg("timeout") = py::none())
+    .def("frame", [](LayoutJob& j){
+      py::array_t<double> res({(py::ssize_t)j.g->n, (py::ssize_t)2});
+      double* out = res.mutable_data();
+      uint64_t number;
+      {
+        py::gil_scoped_release release;
+        number = read_layout_frame(j.frames, out);
+      }
+      return py::make_tuple(number, res);
+    })
+    .def("positions", [](LayoutJob& j){
+      py::array_t<double> res({(py::ssize_t)j.g->n, (py::ssize_t)2});
+      double* out = res.mutable_data();
+      {
+        py::gil_scoped_release release;
+        read_layout_frame(j.frames, out);
+      }
+      return res;
+    })
+    .def("add_done_callback", [](std::shared_ptr<LayoutJob> j, py::object f){
+      {
+        std::lock_guard<std::mutex> lock(j->mutex);
+        if (!j->done) {
+          j->callbacks.push_back(f);
+          return;
+        }
+      }
+      f(py::cast(j));
+    }, py::arg("fn"))
+    .def_property_readonly("graph", [](const LayoutJob& j){ return j.g; })
+    .def("__repr__", [](const LayoutJob& j){
+      return "<LayoutJob iter=" + std::to_string(j.iter.load()) +
+             (j.done ? " done>" : " running>");
+    });
+
+  // -----------------
+  // Stepwise layout session
+  // -----------------
+  py::class_<LayoutSession, std::shared_ptr<LayoutSession>>(m,
+    "LayoutSession",
+    R"pbdoc(
+    Spring layout driven step by step, e.g. for animations or interactive
+    tuning: graph distances are computed once, and temperature and target
+    square carry over from one step to the next.
+
+    The graph is held by the session until close() (also called on exit of
+    a with block): other layouts or reorderings of it raise RuntimeError.
+    With reorder_period > 0 nodes are renumbered internally until then;
+    positions always follow the caller's numbering.
+
+    positions, iteration, max_delta, converged and temperature may be read
+    from other threads while a step runs (they reflect the last completed
+    iteration); once the session is closed they raise RuntimeError.
+    )pbdoc")
+    .def(py::init([](std::shared_ptr<Graph> g, int d, double grav_strength,
+                     double node_edge_repulsion, double node_edge_cutoff_factor,
+                     int reorder_period) {
+      if (g->n <= 1)
+        throw py::value_error("a layout session needs at least 2 nodes");
+      auto session = std::make_shared<LayoutSession>();
+      session->use.reset(new GraphUse(g.get(), true));
+      session->g = g;
+      LayoutParams p = {INT_MAX, d, grav_strength, node_edge_repulsion,
+                        node_edge_cutoff_factor, reorder_period};
+      py::gil_scoped_release release;
+      session->s = layout_init(g.get(), &p);
+      session->frames = new_layout_frames(g.get());
+      session->s->frames = session->frames;
+      session->publish();
+      return session;
+    }),
+    py::arg("graph"), py::arg("d") = 2, py::arg("grav_strength") = 0.01,
+    py::arg("node_edge_repulsion") = -1.0, py::arg("node_edge_cutoff_factor") = -1.0,
+    py::arg("reorder_period") = 0)
+    .def("step", [](LayoutSession& ls, int k) {
+      auto lock = ls.exclusive();
+      LayoutState* s = ls.state();
+      int start = s->iter;
+      py::gil_scoped_release release;
+      for (int i = 0; i < k && layout_step(s); i++)
+        ls.publish();
+      ls.publish(); //converged
+      return s->iter - start;
+    }, py::arg("k") = 1)
+    .def("set_params", [](LayoutSession& ls, std::optional<int> d,
+                          std::optional<double> grav_strength,
+                          std::optional<double> node_edge_repulsion,
+                          std::optional<double> node_edge_cutoff_factor,
+                          std::optional<int> reorder_period) {
+      auto lock = ls.exclusive();
+      LayoutState* s = ls.state();
+      LayoutParams p = s->params;
+      p.d = d.value_or(p.d);
+      p.grav_strength = grav_strength.value_or(p.grav_strength);
+      p.node_edge_repulsion = node_edge_repulsion.value_or(p.node_edge_repulsion);
+      p.node_edge_cutoff_factor = node_edge_cutoff_factor.value_or(p.node_edge_cutoff_factor);
+      p.reorder_period = reorder_period.value_or(p.reorder_period);
+      layout_set_params(s, &p);
+      ls.publish();
+    }, py::arg("d") = py::none(), py::arg("grav_strength") = py::none(),
+    py::arg("node_edge_repulsion") = py::none(),
+    py::arg("node_edge_cutoff_factor") = py::none(),
+    py::arg("reorder_period") = py::none())
+    .def_property_readonly("positions", [](LayoutSession& ls) {
+      ls.check_open();
+      py::array_t<double> res({(py::ssize_t)ls.g->n, (py::ssize_t)2});
+      double* out = res.mutable_data();
+      {
+        py::gil_scoped_release release;
+        read_layout_frame(ls.frames, out);
+      }
+      return res;
+    })
+    .def_property_readonly("iteration", [](LayoutSession& ls) {
+      ls.check_open();
+      return ls.iter.load();
+    })
+    .def_property_readonly("max_delta", [](LayoutSession& ls) {
+      ls.check_open();
+      return ls.max_delta.load();
+    })
+    .def_property_readonly("converged", [](LayoutSession& ls) {
+      ls.check_open();
+      return ls.converged.load();
+    })
+    .def_property("temperature",
+      [](LayoutSession& ls) {
+        ls.check_open();
+        return ls.temperature.load();
+      },
+      [](LayoutSession& ls, double t) {
+        auto lock = ls.exclusive();
+        LayoutState* s = ls.state();
+        s->t = t;
+        s->converged = false;
+        ls.publish();
+      })
+    .def_property_readonly("graph", [](const LayoutSession& ls) { return ls.g; })
+    .def("close", [](LayoutSession& ls) {
+      py::gil_scoped_release release;
+      ls.close();
+    })
+    .def("__enter__", [](std::shared_ptr<LayoutSession> ls) { return ls; })
+    .def("__exit__", [](LayoutSession& ls, py::args) {
+      py::gil_scoped_release release;
+      ls.close();
+    })
+    .def("__repr__", [](const LayoutSession& ls) {
+      return "<LayoutSession iter=" + std::to_string(ls.iter.load()) +
+             (ls.closed ? " closed>" : ">");
+    });
 
   // Spring layout
   m.def(
     "spring_layout",
     [](std::shared_ptr<Graph> g, int max_iter, int d, double grav_strength,
-       double node_edge_repulsion, double node_edge_cutoff_factor) {
-      spring_layout(g.get(), max_iter, d, grav_strength,
-                    node_edge_repulsion, node_edge_cutoff_factor);
+       double node_edge_repulsion, double node_edge_cutoff_factor, int reorder_period,
+       const std::string& checkpoint, int checkpoint_period, bool store_distances,
+       bool resume) {
+      GraphUse use(g.get(), true);
+      if (checkpoint.empty()) {
+        spring_layout(g.get(), max_iter, d, grav_strength,
+                      node_edge_repulsion, node_edge_cutoff_factor, reorder_period);
+        return;
+      }
+      LayoutParams p = {max_iter, d, grav_strength, node_edge_repulsion,
+                        node_edge_cutoff_factor, reorder_period};
+      if (spring_layout_checkpointed(g.get(), &p, checkpoint.c_str(), checkpoint_period,
+                                     store_distances, resume) != 0)
+        throw std::runtime_error(graph_error());
+    },
+    py::arg("graph"), py::arg("max_iter"), py::arg("d") = 2, py::arg("grav_strength") = 0.01,
+    py::arg("node_edge_repulsion") = -1.0, py::arg("node_edge_cutoff_factor") = -1.0,
+    py::arg("reorder_period") = 0, py::arg("checkpoint") = "",
+    py::arg("checkpoint_period") = 100, py::arg("store_distances") = true,
+    py::arg("resume") = false, nogil());
+
+  m.def(
+    "spring_layout_async",
+    [](std::shared_ptr<Graph> g, int max_iter, int d, double grav_strength,
+       double node_edge_repulsion, double node_edge_cutoff_factor, int reorder_period) {
+      auto job = std::make_shared<LayoutJob>();
+      job->use.reset(new GraphUse(g.get(), true));
+      job->g = g;
+      job->params = {max_iter, d, grav_strength, node_edge_repulsion,
+                     node_edge_cutoff_factor, reorder_period};
+      job->frames = new_layout_frames(g.get());
+      WorkerPool::get().submit([job]{ job->run(); });
+      return job;
     },
     py::arg("graph"), py::arg("max_iter"), py::arg("d") = 2, py::arg("grav_strength") = 0.01,
-    py::arg("node_edge_repulsion") = -1.0, py::arg("node_edge_cutoff_factor") = -1.0);
+    py::arg("node_edge_repulsion") = -1.0, py::arg("node_edge_cutoff_factor") = -1.0,
+    py::arg("reorder_period") = 0);
 }
@@ -38,6 +38,7 @@ ext_modules = [
         language="c++",
         extra_compile_args=["-O3", "-std=c++17"],
         extra_objects=["../c_project/bin/libgrem.a"],
+        extra_link_args=["-pthread"],
     )
 ]
 